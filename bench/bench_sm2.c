@@ -0,0 +1,371 @@
+#include "SM2.h"
+#include "SM3.h"
+#include "batch.h"
+#include "cpu.h"
+#include "ecp.h"
+#include "instr.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define MAX_SAMPLES    1000  /* 每项最多采样次数 */
+#define SAMPLE_NS      20000 /* 每个采样批次的目标时长（纳秒） */
+#define MAX_SM3_LEN    (1 << 20)
+#define MAX_VEC        64 /* 批量域运算的最大元素数 */
+#define SIGN_BATCH     64 /* 批量签名的消息条数 */
+
+/* 基准测试共享的数据 */
+typedef struct {
+    group g;
+    bn_t a, b, k;
+    point P, Q;
+    ecp EP, EQ; /* P的Jacobian坐标 */
+    SM2_PRI_KEY pri_key;
+    SM2_PUB_KEY pub_key;
+    SM2_SIG sig;
+    SM2_SIG rsig; /* 对e的可恢复签名（恢复标识为recid） */
+    SM2_SIG bsig[SIGN_BATCH];
+    const uint8_t *bmsg[SIGN_BATCH];
+    size_t blen[SIGN_BATCH];
+    uint8_t e[SM3_DIGEST_SIZE];
+    int recid;
+    uint8_t *msg;
+    size_t mlen;
+    uint32_t state[SM3_STATE_WORDS];
+    uint8_t digest[SM3_DIGEST_SIZE];
+    fp_ctx fp;              /* 模p的定长域运算 */
+    fp_t fa, fb, fc;
+    void *vec_mem;          /* 批量数据的内存 */
+    arena ar;               /* 建在vec_mem上的内存区 */
+    point_batch va, vb, vc; /* 批量域运算的操作数（各取X坐标） */
+} bench_ctx;
+
+typedef struct {
+    const char *name;
+    void (*run)(bench_ctx *ctx, size_t arg);
+    size_t arg; /* 附加参数，如SM3的输入长度 */
+} bench_item;
+
+/* 单项结果 */
+typedef struct {
+    double ns_median;
+    double ns_p99;
+    double cycles_median;
+    size_t samples;
+    uint64_t ops;
+    instr_counters counts; /* 单次操作的运算计数（库以SM2_INSTRUMENT编译时） */
+} bench_result;
+
+static const char *ID = "1234567812345678";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_bn_mod_mul(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    bn_mod_mul(ctx->k, ctx->a, ctx->b, ctx->g.p);
+}
+
+static void run_bn_mod_inv(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    bn_mod_inv(ctx->k, ctx->a, ctx->g.p);
+}
+
+static void run_fp_mul(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    fp_mul(ctx->fc, ctx->fa, ctx->fb, &ctx->fp);
+}
+
+static void run_fp_vec_mul(bench_ctx *ctx, size_t arg) {
+    fp_vec_mul(ctx->vc.x, ctx->va.x, ctx->vb.x, arg, ctx->va.stride, &ctx->fp);
+}
+
+static void run_point_dbl(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    point_dbl(&ctx->Q, &ctx->P, ctx->g.p, ctx->g.a);
+}
+
+static void run_point_add(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    point_add(&ctx->Q, &ctx->P, &ctx->g.g, ctx->g.p, ctx->g.a);
+}
+
+static void run_point_mul(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    point_mul(&ctx->Q, &ctx->g.g, ctx->a, ctx->g.p, ctx->g.a);
+}
+
+static void run_ecp_mul_ct(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    ecp_mul_ct(&ctx->EQ, &ctx->EP, ctx->pri_key.d, &ctx->g);
+}
+
+static void run_ecp_mul_vartime(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    ecp_mul2_vartime(&ctx->EQ, &ctx->EP, ctx->pri_key.d, NULL, NULL, &ctx->g);
+}
+
+static void run_ecp_ladder(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    ecp_ladder(ctx->Q.x, ctx->Q.y, &ctx->P, ctx->pri_key.d, &ctx->g);
+}
+
+static void run_sm3_compress(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    SM3_Compress(ctx->state, ctx->msg);
+}
+
+static void run_sm3(bench_ctx *ctx, size_t arg) {
+    SM3(ctx->msg, arg, ctx->digest);
+}
+
+static void run_keygen(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    SM2_PRI_KEY pri_key;
+    SM2_PUB_KEY pub_key;
+    SM2_GenerateKeyPair(&pri_key, &pub_key, &ctx->g);
+}
+
+static void run_sign(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    SM2_SIG sig;
+    SM2_Sign(&ctx->pri_key, &ctx->g, ctx->msg, ctx->mlen, (uint8_t *)ID, strlen(ID), &sig);
+}
+
+static void run_sign_batch(bench_ctx *ctx, size_t arg) {
+    SM2_SignBatch(&ctx->pri_key, &ctx->g, ctx->bmsg, ctx->blen, arg, (uint8_t *)ID, strlen(ID), ctx->bsig);
+}
+
+static void run_verify(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    if (SM2_Verify(&ctx->pub_key, &ctx->g, ctx->msg, ctx->mlen, (uint8_t *)ID, strlen(ID), &ctx->sig) != SM2_SUCCESS)
+        abort();
+}
+
+static void run_recover(bench_ctx *ctx, size_t arg) {
+    (void)arg;
+    SM2_PUB_KEY pub_key;
+    if (SM2_RecoverPublicKey(&pub_key, &ctx->g, ctx->e, &ctx->rsig, ctx->recid) != SM2_SUCCESS)
+        abort();
+}
+
+static const bench_item ITEMS[] = {
+    {"bn_mod_mul", run_bn_mod_mul, 0},
+    {"bn_mod_inv", run_bn_mod_inv, 0},
+    {"fp_mul", run_fp_mul, 0},
+    {"fp_vec_mul_64", run_fp_vec_mul, MAX_VEC},
+    {"point_dbl", run_point_dbl, 0},
+    {"point_add", run_point_add, 0},
+    {"point_mul", run_point_mul, 0},
+    {"ecp_mul_ct", run_ecp_mul_ct, 0},
+    {"ecp_mul_vartime", run_ecp_mul_vartime, 0},
+    {"ecp_ladder", run_ecp_ladder, 0},
+    {"SM3_Compress", run_sm3_compress, 0},
+    {"SM3_64B", run_sm3, 64},
+    {"SM3_256B", run_sm3, 256},
+    {"SM3_1KB", run_sm3, 1024},
+    {"SM3_16KB", run_sm3, 16384},
+    {"SM3_1MB", run_sm3, MAX_SM3_LEN},
+    {"SM2_GenerateKeyPair", run_keygen, 0},
+    {"SM2_Sign", run_sign, 0},
+    {"SM2_SignBatch_64", run_sign_batch, SIGN_BATCH},
+    {"SM2_Verify", run_verify, 0},
+    {"SM2_RecoverPublicKey", run_recover, 0},
+};
+
+static void bench_setup(bench_ctx *ctx) {
+    SM2_GenerateKeyPair(&ctx->pri_key, &ctx->pub_key, &ctx->g);
+
+    bn_new(ctx->a);
+    bn_new(ctx->b);
+    bn_new(ctx->k);
+    bn_rand_mod(ctx->a, ctx->g.p);
+    bn_rand_mod(ctx->b, ctx->g.p);
+
+    point_new(&ctx->P);
+    point_new(&ctx->Q);
+    point_mul(&ctx->P, &ctx->g.g, ctx->b, ctx->g.p, ctx->g.a);
+    ecp_set_point(&ctx->EP, &ctx->P, &ctx->g);
+
+    fp_ctx_init(&ctx->fp, ctx->g.p);
+    fp_from_bn(ctx->fa, ctx->a, &ctx->fp);
+    fp_from_bn(ctx->fb, ctx->b, &ctx->fp);
+    size_t vec_bytes = 3 * point_batch_bytes(MAX_VEC);
+    ctx->vec_mem = malloc(vec_bytes);
+    if (ctx->vec_mem == NULL)
+        abort();
+    arena_init(&ctx->ar, ctx->vec_mem, vec_bytes);
+    point_batch_init(&ctx->va, &ctx->ar, MAX_VEC);
+    point_batch_init(&ctx->vb, &ctx->ar, MAX_VEC);
+    point_batch_init(&ctx->vc, &ctx->ar, MAX_VEC);
+    for (size_t j = 0; j < MAX_VEC; j++) {
+        fp_vec_set(ctx->va.x, ctx->va.stride, j, ctx->fa);
+        fp_vec_set(ctx->vb.x, ctx->vb.stride, j, ctx->fb);
+        fp_mul(ctx->fa, ctx->fa, ctx->fb, &ctx->fp);
+    }
+
+    ctx->msg = malloc(MAX_SM3_LEN);
+    if (ctx->msg == NULL)
+        abort();
+    for (size_t i = 0; i < MAX_SM3_LEN; i++)
+        ctx->msg[i] = (uint8_t)(i * 131 + 7);
+    ctx->mlen = 64;
+    memset(ctx->state, 0, sizeof(ctx->state));
+
+    SM2_Sign(&ctx->pri_key, &ctx->g, ctx->msg, ctx->mlen, (uint8_t *)ID, strlen(ID), &ctx->sig);
+    SM3(ctx->msg, ctx->mlen, ctx->e);
+    for (size_t j = 0; j < SIGN_BATCH; j++) {
+        ctx->bmsg[j] = ctx->msg + j;
+        ctx->blen[j] = ctx->mlen;
+    }
+    SM2_SignDigestRecoverable(&ctx->pri_key, &ctx->g, ctx->e, &ctx->rsig, &ctx->recid);
+}
+
+/*
+ * 每个采样为一批连续操作的平均耗时，批大小按预热结果取约SAMPLE_NS，
+ * 直到累计时间达到min_ns且采样数不少于min_samples。
+ */
+static void bench_run(const bench_item *item, bench_ctx *ctx, uint64_t min_ns, size_t min_samples,
+                      bench_result *res) {
+    static double ns[MAX_SAMPLES], cycles[MAX_SAMPLES];
+    uint64_t t0, t1, c0, c1, total = 0, batch = 1, warm;
+    size_t n = 0;
+
+    /* 预热并估计单次耗时 */
+    t0 = now_ns();
+    for (warm = 0; warm < 3 || now_ns() - t0 < min_ns / 10; warm++)
+        item->run(ctx, item->arg);
+    t1 = now_ns();
+    if ((t1 - t0) / warm < SAMPLE_NS)
+        batch = SAMPLE_NS / ((t1 - t0) / warm + 1) + 1;
+
+    res->ops = 0;
+    while (n < MAX_SAMPLES && (total < min_ns || n < min_samples)) {
+        c0 = now_cycles();
+        t0 = now_ns();
+        for (uint64_t i = 0; i < batch; i++)
+            item->run(ctx, item->arg);
+        t1 = now_ns();
+        c1 = now_cycles();
+
+        ns[n] = (double)(t1 - t0) / batch;
+        cycles[n] = (double)(c1 - c0) / batch;
+        total += t1 - t0;
+        res->ops += batch;
+        n++;
+    }
+
+    qsort(ns, n, sizeof(double), cmp_double);
+    qsort(cycles, n, sizeof(double), cmp_double);
+    res->ns_median = ns[n / 2];
+    res->ns_p99 = ns[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+    res->cycles_median = cycles[n / 2];
+    res->samples = n;
+
+    instr_reset();
+    item->run(ctx, item->arg);
+    instr_snapshot(&res->counts);
+}
+
+static void print_counts(const instr_counters *counts) {
+    printf(", \"counts\": {");
+    for (int c = 0; c < INSTR_COUNTERS; c++)
+        printf("%s\"%s\": %llu", c ? ", " : "", instr_counter_name(c), (unsigned long long)counts->count[c]);
+    for (int s = 0; s < INSTR_STAGES; s++)
+        printf(", \"%s_cycles\": %llu", instr_stage_name(s), (unsigned long long)counts->stage_cycles[s]);
+    printf("}");
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: bench_sm2 [--format json|csv] [--min-time MS] [--runs N] [--filter NAME] [--disable MASK]\n"
+                    "  --disable MASK  mask out CPU_* feature bits (e.g. 0x8 = AVX-512 IFMA) to time fallback paths\n");
+}
+
+int main(int argc, char **argv) {
+    const char *format = "json", *filter = NULL;
+    uint64_t min_ns = 200000000u;
+    size_t min_samples = 11, count = sizeof(ITEMS) / sizeof(ITEMS[0]);
+    bench_ctx ctx;
+    int first = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_ns = strtoull(argv[++i], NULL, 10) * 1000000u;
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            min_samples = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--disable") == 0 && i + 1 < argc) {
+            cpu_disable((unsigned int)strtoul(argv[++i], NULL, 0));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+        usage();
+        return 2;
+    }
+
+    bench_setup(&ctx);
+
+    if (strcmp(format, "json") == 0)
+        printf("{\n  \"cpu_features\": %u,\n  \"results\": [\n", cpu_features());
+    else
+        printf("name,ops_per_sec,ns_per_op_median,ns_per_op_p99,cycles_per_op,samples,ops\n");
+
+    for (size_t i = 0; i < count; i++) {
+        bench_result res;
+
+        if (filter != NULL && strstr(ITEMS[i].name, filter) == NULL)
+            continue;
+        bench_run(&ITEMS[i], &ctx, min_ns, min_samples, &res);
+
+        if (strcmp(format, "json") == 0) {
+            printf("%s    {\"name\": \"%s\", \"ops_per_sec\": %.1f, \"ns_per_op_median\": %.1f, "
+                   "\"ns_per_op_p99\": %.1f, \"cycles_per_op\": %.1f, \"samples\": %zu, \"ops\": %llu",
+                   first ? "" : ",\n", ITEMS[i].name, 1e9 / res.ns_median, res.ns_median, res.ns_p99,
+                   res.cycles_median, res.samples, (unsigned long long)res.ops);
+            if (instr_enabled())
+                print_counts(&res.counts);
+            printf("}");
+        } else {
+            printf("%s,%.1f,%.1f,%.1f,%.1f,%zu,%llu\n", ITEMS[i].name, 1e9 / res.ns_median, res.ns_median,
+                   res.ns_p99, res.cycles_median, res.samples, (unsigned long long)res.ops);
+        }
+        fflush(stdout);
+        first = 0;
+    }
+
+    if (strcmp(format, "json") == 0)
+        printf("\n  ]\n}\n");
+
+    free(ctx.msg);
+    free(ctx.vec_mem);
+    return 0;
+}
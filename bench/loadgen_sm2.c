@@ -0,0 +1,428 @@
+#include "SM2.h"
+#include "SM3.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_STEPS   16   /* 线程数列表最大长度 */
+#define MAX_SIZES   16   /* 消息长度分布最大项数 */
+#define HIST_SUB    64   /* 每个2的幂区间内的线性子桶数（相对误差约1.6%） */
+#define HIST_EXP    44   /* 最大记录值约2^44纳秒 */
+#define HIST_SIZE   ((HIST_EXP - 5) * HIST_SUB)
+
+enum { OP_SIGN, OP_VERIFY, OP_HASH, OP_COUNT };
+static const char *OP_NAME[OP_COUNT] = {"sign", "verify", "hash"};
+
+/* 对数-线性延迟直方图（HDR风格），单位纳秒 */
+typedef struct {
+    uint64_t counts[HIST_SIZE];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+} histogram;
+
+/* 运行配置 */
+typedef struct {
+    int threads[MAX_STEPS];
+    int nsteps;
+    double duration;               /* 每个线程数下的运行时间（秒） */
+    double rate;                   /* 目标总速率（次/秒），0表示不限速 */
+    unsigned int mix[OP_COUNT];    /* 各操作的权重 */
+    size_t sizes[MAX_SIZES];       /* 消息长度 */
+    unsigned int weights[MAX_SIZES];
+    int nsizes;
+    int nkeys;                     /* 密钥集合大小 */
+    int json;
+} loadgen_cfg;
+
+/* 共享的只读数据：密钥集合与每个(密钥, 长度)对应的预生成签名 */
+typedef struct {
+    group g;
+    SM2_PRI_KEY *pri;
+    SM2_PUB_KEY *pub;
+    SM2_SIG *sig;                  /* sig[key * nsizes + size] */
+    uint8_t *msg;
+} loadgen_data;
+
+typedef struct {
+    const loadgen_cfg *cfg;
+    const loadgen_data *data;
+    atomic_int *stop;
+    uint64_t seed;
+    int threads;
+    histogram hist[OP_COUNT];
+    uint64_t errors;
+} loadgen_worker;
+
+static const char *ID = "1234567812345678";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000u;
+    ts.tv_nsec = ns % 1000000000u;
+    nanosleep(&ts, NULL);
+}
+
+static uint64_t xorshift64(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static size_t hist_index(uint64_t v) {
+    int e;
+    size_t idx;
+
+    if (v < HIST_SUB)
+        return v;
+    e = 63 - __builtin_clzll(v);
+    idx = (size_t)(e - 5) * HIST_SUB + (size_t)((v >> (e - 6)) - HIST_SUB);
+    return idx < HIST_SIZE ? idx : HIST_SIZE - 1;
+}
+
+/* 子桶的最大等价值 */
+static uint64_t hist_value(size_t idx) {
+    int e;
+
+    if (idx < HIST_SUB)
+        return idx;
+    e = (int)(idx / HIST_SUB) + 5;
+    return (((uint64_t)(idx % HIST_SUB + HIST_SUB + 1)) << (e - 6)) - 1;
+}
+
+static void hist_record(histogram *h, uint64_t v) {
+    h->counts[hist_index(v)]++;
+    h->total++;
+    h->sum += v;
+    if (v > h->max)
+        h->max = v;
+}
+
+static void hist_merge(histogram *dst, const histogram *src) {
+    for (size_t i = 0; i < HIST_SIZE; i++)
+        dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+static uint64_t hist_percentile(const histogram *h, double q) {
+    uint64_t target = (uint64_t)(q / 100.0 * h->total + 0.5), seen = 0;
+
+    if (target == 0)
+        target = 1;
+    for (size_t i = 0; i < HIST_SIZE; i++) {
+        seen += h->counts[i];
+        if (seen >= target)
+            return hist_value(i) < h->max ? hist_value(i) : h->max;
+    }
+    return h->max;
+}
+
+static int pick(const unsigned int *weights, int n, uint64_t r) {
+    unsigned int total = 0;
+
+    for (int i = 0; i < n; i++)
+        total += weights[i];
+    r %= total;
+    for (int i = 0; i < n; i++) {
+        if (r < weights[i])
+            return i;
+        r -= weights[i];
+    }
+    return n - 1;
+}
+
+/*
+ * 工作线程：按权重随机选择操作、密钥与消息长度。限速时采用开环调度，
+ * 延迟从计划开始时间算起，避免协同遗漏（coordinated omission）。
+ */
+static void *loadgen_run(void *arg) {
+    loadgen_worker *w = arg;
+    const loadgen_cfg *cfg = w->cfg;
+    const loadgen_data *data = w->data;
+    uint64_t interval = 0, next, start, end;
+    uint8_t digest[SM3_DIGEST_SIZE];
+    SM2_SIG sig;
+
+    if (cfg->rate > 0)
+        interval = (uint64_t)(1e9 * w->threads / cfg->rate);
+    next = now_ns();
+
+    while (!atomic_load_explicit(w->stop, memory_order_relaxed)) {
+        int op = pick(cfg->mix, OP_COUNT, xorshift64(&w->seed));
+        int key = (int)(xorshift64(&w->seed) % cfg->nkeys);
+        int size = pick(cfg->weights, cfg->nsizes, xorshift64(&w->seed));
+        size_t len = cfg->sizes[size];
+
+        if (interval > 0) {
+            uint64_t now = now_ns();
+            if (now < next)
+                sleep_ns(next - now);
+            start = next;
+            next += interval;
+        } else {
+            start = now_ns();
+        }
+
+        switch (op) {
+        case OP_SIGN:
+            if (SM2_Sign(&data->pri[key], (group *)&data->g, data->msg, len, (uint8_t *)ID, strlen(ID), &sig) !=
+                SM2_SUCCESS)
+                w->errors++;
+            break;
+        case OP_VERIFY:
+            if (SM2_Verify(&data->pub[key], (group *)&data->g, data->msg, len, (uint8_t *)ID, strlen(ID),
+                           &data->sig[key * cfg->nsizes + size]) != SM2_SUCCESS)
+                w->errors++;
+            break;
+        default:
+            SM3(data->msg, len, digest);
+            break;
+        }
+
+        end = now_ns();
+        hist_record(&w->hist[op], end > start ? end - start : 0);
+    }
+
+    return NULL;
+}
+
+static void loadgen_setup(const loadgen_cfg *cfg, loadgen_data *data) {
+    size_t max_len = 1;
+
+    for (int i = 0; i < cfg->nsizes; i++)
+        if (cfg->sizes[i] > max_len)
+            max_len = cfg->sizes[i];
+
+    data->pri = malloc(cfg->nkeys * sizeof(SM2_PRI_KEY));
+    data->pub = malloc(cfg->nkeys * sizeof(SM2_PUB_KEY));
+    data->sig = malloc((size_t)cfg->nkeys * cfg->nsizes * sizeof(SM2_SIG));
+    data->msg = malloc(max_len);
+    if (data->pri == NULL || data->pub == NULL || data->sig == NULL || data->msg == NULL) {
+        fprintf(stderr, "loadgen_sm2: out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < max_len; i++)
+        data->msg[i] = (uint8_t)(i * 131 + 7);
+
+    for (int k = 0; k < cfg->nkeys; k++) {
+        SM2_GenerateKeyPair(&data->pri[k], &data->pub[k], &data->g);
+        for (int s = 0; s < cfg->nsizes; s++)
+            SM2_Sign(&data->pri[k], &data->g, data->msg, cfg->sizes[s], (uint8_t *)ID, strlen(ID),
+                     &data->sig[k * cfg->nsizes + s]);
+    }
+}
+
+/* 解析"a,b,c"形式的线程数列表 */
+static int parse_threads(loadgen_cfg *cfg, const char *s) {
+    char *end;
+
+    cfg->nsteps = 0;
+    while (*s != '\0' && cfg->nsteps < MAX_STEPS) {
+        long n = strtol(s, &end, 10);
+        if (end == s || n < 1)
+            return -1;
+        cfg->threads[cfg->nsteps++] = (int)n;
+        s = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+            return -1;
+    }
+    return cfg->nsteps > 0 ? 0 : -1;
+}
+
+/* 解析"sign:verify:hash"形式的权重 */
+static int parse_mix(loadgen_cfg *cfg, const char *s) {
+    unsigned int a, b, c;
+
+    if (sscanf(s, "%u:%u:%u", &a, &b, &c) != 3 || a + b + c == 0)
+        return -1;
+    cfg->mix[OP_SIGN] = a;
+    cfg->mix[OP_VERIFY] = b;
+    cfg->mix[OP_HASH] = c;
+    return 0;
+}
+
+/* 解析"长度:权重,长度:权重"形式的消息长度分布 */
+static int parse_sizes(loadgen_cfg *cfg, const char *s) {
+    char *end;
+    unsigned int total = 0;
+
+    cfg->nsizes = 0;
+    while (*s != '\0' && cfg->nsizes < MAX_SIZES) {
+        unsigned long long len = strtoull(s, &end, 10);
+        unsigned long weight = 1;
+        if (end == s)
+            return -1;
+        if (*end == ':') {
+            s = end + 1;
+            weight = strtoul(s, &end, 10);
+            if (end == s)
+                return -1;
+        }
+        cfg->sizes[cfg->nsizes] = (size_t)len;
+        cfg->weights[cfg->nsizes++] = (unsigned int)weight;
+        total += (unsigned int)weight;
+        if (*end != ',' && *end != '\0')
+            return -1;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return cfg->nsizes > 0 && total > 0 ? 0 : -1;
+}
+
+static void print_step(const loadgen_cfg *cfg, int threads, double elapsed, const histogram *hist, uint64_t errors,
+                       double base, int first) {
+    static const double Q[] = {50, 90, 99, 99.9};
+    uint64_t total = 0;
+    double tput;
+
+    for (int op = 0; op < OP_COUNT; op++)
+        total += hist[op].total;
+    tput = total / elapsed;
+
+    if (cfg->json) {
+        printf("%s    {\"threads\": %d, \"seconds\": %.3f, \"ops_per_sec\": %.1f, \"efficiency\": %.3f, "
+               "\"errors\": %llu, \"ops\": {",
+               first ? "" : ",\n", threads, elapsed, tput, base > 0 ? tput / base : 1.0,
+               (unsigned long long)errors);
+        for (int op = 0, n = 0; op < OP_COUNT; op++) {
+            if (hist[op].total == 0)
+                continue;
+            printf("%s\"%s\": {\"count\": %llu, \"ops_per_sec\": %.1f, \"mean_ns\": %.0f", n++ ? ", " : "",
+                   OP_NAME[op], (unsigned long long)hist[op].total, hist[op].total / elapsed,
+                   (double)hist[op].sum / hist[op].total);
+            for (size_t i = 0; i < sizeof(Q) / sizeof(Q[0]); i++)
+                printf(", \"p%g_ns\": %llu", Q[i], (unsigned long long)hist_percentile(&hist[op], Q[i]));
+            printf(", \"max_ns\": %llu}", (unsigned long long)hist[op].max);
+        }
+        printf("}}");
+        return;
+    }
+
+    printf("threads %d: %.1f ops/s (efficiency %.2f), errors %llu\n", threads, tput, base > 0 ? tput / base : 1.0,
+           (unsigned long long)errors);
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (hist[op].total == 0)
+            continue;
+        printf("  %-6s %10.1f ops/s  mean %9.1f us", OP_NAME[op], hist[op].total / elapsed,
+               (double)hist[op].sum / hist[op].total / 1000.0);
+        for (size_t i = 0; i < sizeof(Q) / sizeof(Q[0]); i++)
+            printf("  p%g %9.1f us", Q[i], hist_percentile(&hist[op], Q[i]) / 1000.0);
+        printf("  max %9.1f us\n", hist[op].max / 1000.0);
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: loadgen_sm2 [-t THREADS[,THREADS...]] [-d SECONDS] [-r RATE] [-m SIGN:VERIFY:HASH]\n"
+                    "                   [-s SIZE[:WEIGHT][,...]] [-k KEYS] [--json]\n");
+}
+
+int main(int argc, char **argv) {
+    loadgen_cfg cfg = {.threads = {1}, .nsteps = 1, .duration = 5.0, .rate = 0, .mix = {1, 1, 1},
+                       .sizes = {64}, .weights = {1}, .nsizes = 1, .nkeys = 4, .json = 0};
+    loadgen_data data;
+    double base = 0;
+
+    for (int i = 1; i < argc; i++) {
+        int ok = i + 1 < argc;
+        if (strcmp(argv[i], "-t") == 0 && ok) {
+            ok = parse_threads(&cfg, argv[++i]) == 0;
+        } else if (strcmp(argv[i], "-d") == 0 && ok) {
+            cfg.duration = atof(argv[++i]);
+            ok = cfg.duration > 0;
+        } else if (strcmp(argv[i], "-r") == 0 && ok) {
+            cfg.rate = atof(argv[++i]);
+            ok = cfg.rate >= 0;
+        } else if (strcmp(argv[i], "-m") == 0 && ok) {
+            ok = parse_mix(&cfg, argv[++i]) == 0;
+        } else if (strcmp(argv[i], "-s") == 0 && ok) {
+            ok = parse_sizes(&cfg, argv[++i]) == 0;
+        } else if (strcmp(argv[i], "-k") == 0 && ok) {
+            cfg.nkeys = atoi(argv[++i]);
+            ok = cfg.nkeys > 0;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            cfg.json = ok = 1;
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+
+    loadgen_setup(&cfg, &data);
+
+    if (cfg.json)
+        printf("{\n  \"rate\": %.1f, \"keys\": %d,\n  \"steps\": [\n", cfg.rate, cfg.nkeys);
+
+    for (int step = 0; step < cfg.nsteps; step++) {
+        int threads = cfg.threads[step], started;
+        loadgen_worker *workers = calloc(threads, sizeof(loadgen_worker));
+        pthread_t *tids = malloc(threads * sizeof(pthread_t));
+        histogram *hist = calloc(OP_COUNT, sizeof(histogram));
+        atomic_int stop = 0;
+        uint64_t t0, errors = 0;
+        double elapsed, tput = 0;
+
+        if (workers == NULL || tids == NULL || hist == NULL) {
+            fprintf(stderr, "loadgen_sm2: out of memory\n");
+            return 1;
+        }
+
+        t0 = now_ns();
+        for (started = 0; started < threads; started++) {
+            workers[started].cfg = &cfg;
+            workers[started].data = &data;
+            workers[started].stop = &stop;
+            workers[started].threads = threads;
+            workers[started].seed = 0x9E3779B97F4A7C15ull * (started + 1) ^ t0;
+            if (pthread_create(&tids[started], NULL, loadgen_run, &workers[started]) != 0)
+                break;
+        }
+        sleep_ns((uint64_t)(cfg.duration * 1e9));
+        atomic_store(&stop, 1);
+        for (int t = 0; t < started; t++)
+            pthread_join(tids[t], NULL);
+        elapsed = (now_ns() - t0) / 1e9;
+
+        for (int t = 0; t < started; t++) {
+            for (int op = 0; op < OP_COUNT; op++)
+                hist_merge(&hist[op], &workers[t].hist[op]);
+            errors += workers[t].errors;
+        }
+
+        /* 扩展效率 = 吞吐量 / (线程数 * 第一步的每线程吞吐量) */
+        print_step(&cfg, started, elapsed, hist, errors, base * started, step == 0);
+        for (int op = 0; op < OP_COUNT; op++)
+            tput += hist[op].total / elapsed;
+        if (step == 0 && started > 0)
+            base = tput / started;
+        fflush(stdout);
+
+        free(workers);
+        free(tids);
+        free(hist);
+    }
+
+    if (cfg.json)
+        printf("\n  ]\n}\n");
+
+    free(data.pri);
+    free(data.pub);
+    free(data.sig);
+    free(data.msg);
+    return 0;
+}
@@ -0,0 +1,368 @@
+#include "SM2.h"
+#include "SM3.h"
+#include "ecp.h"
+#include "instr.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * 性能回归检查：运行固定的基准集合，与基线文件比较。
+ * 基线文件每行一项（#开头为注释）：
+ *   time  <项目> <ns/op> <允许变慢的比例>   最快采样的耗时超过 基线 * (1 + 比例) 即失败
+ *   count <项目> <计数器> <次数>            单次操作的运算计数必须完全一致
+ * 运算计数要求库以SM2_INSTRUMENT编译；输入固定，因而计数是确定的。
+ * --counts-only只检查计数行，不计时，结果与机器负载无关，可作为常规测试运行。
+ */
+
+#define MAX_LINES    128
+#define MAX_SM3_LEN  (1 << 20)
+#define SAMPLES      15
+#define SAMPLE_NS    20000000u /* 每个采样的目标时长（纳秒） */
+
+typedef struct {
+    group g;
+    bn_t a, b, c, k;
+    point Q;
+    fp_t fa, fb, fc;
+    ecp EP, EQ; /* G与结果的Jacobian坐标 */
+    SM2_PRI_KEY pri_key;
+    SM2_PUB_KEY pub_key;
+    SM2_SIG sig;
+    uint8_t *msg;
+    uint8_t digest[SM3_DIGEST_SIZE];
+} regress_ctx;
+
+typedef struct {
+    const char *name;
+    void (*run)(regress_ctx *ctx, size_t arg);
+    size_t arg;
+} regress_item;
+
+typedef struct {
+    int is_count;
+    char name[64];
+    char counter[32];
+    double value;
+    double tolerance;
+} baseline_line;
+
+static const char *ID = "1234567812345678";
+static const char *MSG = "message digest";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_mod_mul(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    bn_mod_mul(ctx->c, ctx->a, ctx->b, ctx->g.p);
+}
+
+static void run_mod_inv(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    bn_mod_inv(ctx->c, ctx->a, ctx->g.p);
+}
+
+static void run_fp_mul(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    fp_mul(ctx->fc, ctx->fa, ctx->fb, &ctx->g.fp);
+}
+
+static void run_fp_inv(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    fp_inv(ctx->fc, ctx->fa, &ctx->g.fp);
+}
+
+static void run_ecp_mul_ct(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    ecp_mul_ct(&ctx->EQ, &ctx->EP, ctx->k, &ctx->g);
+}
+
+static void run_point_mul(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    point_mul(&ctx->Q, &ctx->g.g, ctx->k, ctx->g.p, ctx->g.a);
+}
+
+static void run_sign(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    SM2_SIG sig;
+    SM2_Sign(&ctx->pri_key, &ctx->g, (const uint8_t *)MSG, strlen(MSG), (uint8_t *)ID, strlen(ID), &sig);
+}
+
+static void run_verify(regress_ctx *ctx, size_t arg) {
+    (void)arg;
+    if (SM2_Verify(&ctx->pub_key, &ctx->g, (const uint8_t *)MSG, strlen(MSG), (uint8_t *)ID, strlen(ID),
+                   &ctx->sig) != SM2_SUCCESS) {
+        fprintf(stderr, "perf_regress: verification of the fixed vector failed\n");
+        exit(1);
+    }
+}
+
+static void run_sm3(regress_ctx *ctx, size_t arg) {
+    SM3(ctx->msg, arg, ctx->digest);
+}
+
+static const regress_item ITEMS[] = {
+    {"bn_mod_mul", run_mod_mul, 0},
+    {"bn_mod_inv", run_mod_inv, 0},
+    {"fp_mul", run_fp_mul, 0},
+    {"fp_inv", run_fp_inv, 0},
+    {"ecp_mul_ct", run_ecp_mul_ct, 0},
+    {"point_mul", run_point_mul, 0},
+    {"SM2_Sign", run_sign, 0},
+    {"SM2_Verify", run_verify, 0},
+    {"SM3_64B", run_sm3, 64},
+    {"SM3_1KB", run_sm3, 1024},
+    {"SM3_1MB", run_sm3, MAX_SM3_LEN},
+};
+
+#define NITEMS (sizeof(ITEMS) / sizeof(ITEMS[0]))
+
+/*
+ * 固定输入：私钥与k取自SM2.h中的测试常量，签名按标准步骤直接计算，
+ * 使验签的运算计数确定
+ */
+static void regress_setup(regress_ctx *ctx) {
+    uint8_t z[SM3_DIGEST_SIZE], d[SM2_SCALAR_SIZE];
+    SM3_CTX sm3;
+    bn_t e, t;
+    point P;
+
+    create_group(&ctx->g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX,
+                 SM2_CURVE_PARAM_GY, SM2_CURVE_PARAM_N);
+    bn_new(ctx->a);
+    bn_new(ctx->b);
+    bn_new(ctx->c);
+    bn_new(ctx->k);
+    bn_new(e);
+    bn_new(t);
+    bn_new(ctx->pri_key.d);
+    point_new(&ctx->Q);
+    point_new(&P);
+
+    bn_from_hex(ctx->pri_key.d, SM2_ENC_PRI_KEY);
+    bn_from_hex(ctx->k, SM2_ENC_K);
+    bn_copy(ctx->a, ctx->g.g.x);
+    bn_copy(ctx->b, ctx->g.g.y);
+    fp_from_bn(ctx->fa, ctx->a, &ctx->g.fp);
+    fp_from_bn(ctx->fb, ctx->b, &ctx->g.fp);
+    ecp_set_point(&ctx->EP, &ctx->g.g, &ctx->g);
+    point_mul(&ctx->pub_key.p, &ctx->g.g, ctx->pri_key.d, ctx->g.p, ctx->g.a);
+    // 私钥经SM2_DecodePriKey构造，签名时直接使用其中的公钥
+    bn_to_bytes(d, SM2_SCALAR_SIZE, ctx->pri_key.d);
+    SM2_DecodePriKey(&ctx->pri_key, &ctx->g, d);
+
+    // e = H(Z || M)
+    SM2_ComputeZ(z, &ctx->g, &ctx->pub_key.p, (const uint8_t *)ID, strlen(ID));
+    SM3_Init(&sm3);
+    SM3_Update(&sm3, z, SM3_DIGEST_SIZE);
+    SM3_Update(&sm3, (const uint8_t *)MSG, strlen(MSG));
+    SM3_Final(&sm3, ctx->digest);
+    bn_from_digest(e, ctx->digest);
+
+    // r = (e + x1) mod n, s = (1 + d)^-1 * (k - r * d) mod n
+    point_mul(&P, &ctx->g.g, ctx->k, ctx->g.p, ctx->g.a);
+    bn_new(ctx->sig.r);
+    bn_new(ctx->sig.s);
+    bn_mod_add(ctx->sig.r, e, P.x, ctx->g.n);
+    bn_mod_mul(t, ctx->sig.r, ctx->pri_key.d, ctx->g.n);
+    bn_mod_sub(t, ctx->k, t, ctx->g.n);
+    bn_add_dig(ctx->sig.s, ctx->pri_key.d, 1);
+    bn_mod_inv(ctx->sig.s, ctx->sig.s, ctx->g.n);
+    bn_mod_mul(ctx->sig.s, ctx->sig.s, t, ctx->g.n);
+
+    ctx->msg = malloc(MAX_SM3_LEN);
+    if (ctx->msg == NULL)
+        abort();
+    for (size_t i = 0; i < MAX_SM3_LEN; i++)
+        ctx->msg[i] = (uint8_t)(i * 131 + 7);
+}
+
+/* 每个采样运行约SAMPLE_NS，返回最快采样的每次操作耗时（干扰只会使耗时变长） */
+static double regress_time(const regress_item *item, regress_ctx *ctx) {
+    double ns[SAMPLES];
+    uint64_t t0, batch = 1, elapsed;
+
+    t0 = now_ns();
+    item->run(ctx, item->arg);
+    elapsed = now_ns() - t0;
+    if (elapsed < SAMPLE_NS)
+        batch = SAMPLE_NS / (elapsed + 1) + 1;
+
+    for (int i = 0; i < SAMPLES; i++) {
+        t0 = now_ns();
+        for (uint64_t j = 0; j < batch; j++)
+            item->run(ctx, item->arg);
+        ns[i] = (double)(now_ns() - t0) / batch;
+    }
+    qsort(ns, SAMPLES, sizeof(double), cmp_double);
+    return ns[0];
+}
+
+static int find_counter(const char *name) {
+    for (int c = 0; c < INSTR_COUNTERS; c++)
+        if (strcmp(instr_counter_name(c), name) == 0)
+            return c;
+    return -1;
+}
+
+static int find_item(const char *name) {
+    for (size_t i = 0; i < NITEMS; i++)
+        if (strcmp(ITEMS[i].name, name) == 0)
+            return (int)i;
+    return -1;
+}
+
+static int load_baseline(const char *path, baseline_line *lines) {
+    char buf[256], kind[16];
+    FILE *fp = fopen(path, "r");
+    int n = 0;
+
+    if (fp == NULL)
+        return -1;
+    while (fgets(buf, sizeof(buf), fp) != NULL && n < MAX_LINES) {
+        baseline_line *l = &lines[n];
+        if (buf[0] == '#' || sscanf(buf, "%15s", kind) != 1)
+            continue;
+        memset(l, 0, sizeof(*l));
+        if (strcmp(kind, "time") == 0 &&
+            sscanf(buf, "%*s %63s %lf %lf", l->name, &l->value, &l->tolerance) == 3) {
+            l->is_count = 0;
+        } else if (strcmp(kind, "count") == 0 &&
+                   sscanf(buf, "%*s %63s %31s %lf", l->name, l->counter, &l->value) == 3) {
+            l->is_count = 1;
+        } else {
+            fprintf(stderr, "perf_regress: bad baseline line: %s", buf);
+            fclose(fp);
+            return -1;
+        }
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+static int save_baseline(const char *path, const baseline_line *lines, int n) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL)
+        return -1;
+    fprintf(fp, "# perf_regress baseline\n");
+    fprintf(fp, "# time  <item> <ns/op> <allowed slowdown>\n");
+    fprintf(fp, "# count <item> <counter> <exact count per op>\n");
+    for (int i = 0; i < n; i++) {
+        if (lines[i].is_count)
+            fprintf(fp, "count %-12s %-12s %.0f\n", lines[i].name, lines[i].counter, lines[i].value);
+        else
+            fprintf(fp, "time  %-12s %-12.1f %.2f\n", lines[i].name, lines[i].value, lines[i].tolerance);
+    }
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static baseline_line lines[MAX_LINES];
+    double ns[NITEMS];
+    instr_counters counts[NITEMS];
+    regress_ctx ctx;
+    const char *path = NULL;
+    int update = 0, counts_only = 0, failed = 0, n;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0)
+            update = 1;
+        else if (strcmp(argv[i], "--counts-only") == 0)
+            counts_only = 1;
+        else if (path == NULL)
+            path = argv[i];
+        else
+            path = NULL, i = argc;
+    }
+    if (path == NULL) {
+        fprintf(stderr, "usage: perf_regress [--update] [--counts-only] BASELINE\n");
+        return 2;
+    }
+
+    n = load_baseline(path, lines);
+    if (n < 0) {
+        fprintf(stderr, "perf_regress: cannot read %s\n", path);
+        return 2;
+    }
+
+    regress_setup(&ctx);
+    for (size_t i = 0; i < NITEMS; i++) {
+        // 计时之后缓存（如签名的Z缓存）已预热；只检查计数时先运行一次，使计数与计时运行一致
+        if (counts_only) {
+            ns[i] = 0;
+            ITEMS[i].run(&ctx, ITEMS[i].arg);
+        } else {
+            ns[i] = regress_time(&ITEMS[i], &ctx);
+        }
+        instr_reset();
+        ITEMS[i].run(&ctx, ITEMS[i].arg);
+        instr_snapshot(&counts[i]);
+    }
+
+    if (!instr_enabled())
+        printf("note: library built without SM2_INSTRUMENT, count checks skipped\n");
+
+    for (int i = 0; i < n; i++) {
+        baseline_line *l = &lines[i];
+        int item = find_item(l->name), c;
+        double cur;
+
+        if (item < 0) {
+            printf("%-12s unknown item, ignored\n", l->name);
+            continue;
+        }
+
+        if (!l->is_count) {
+            // 只检查计数时计时行（连同--update时的基线值）保持不变
+            if (counts_only)
+                continue;
+            cur = ns[item];
+            int slow = cur > l->value * (1 + l->tolerance);
+            printf("%-12s %-12s %14.1f %14.1f  %6.2fx  %s\n", l->name, "ns/op", l->value, cur, cur / l->value,
+                   slow ? "FAIL" : "ok");
+            failed |= slow;
+        } else {
+            c = find_counter(l->counter);
+            if (c < 0) {
+                printf("%-12s %-12s unknown counter\n", l->name, l->counter);
+                failed = 1;
+                continue;
+            }
+            if (!instr_enabled())
+                continue;
+            cur = (double)counts[item].count[c];
+            printf("%-12s %-12s %14.0f %14.0f  %7s  %s\n", l->name, l->counter, l->value, cur, "",
+                   cur != l->value ? "FAIL" : "ok");
+            failed |= cur != l->value;
+        }
+        if (update)
+            l->value = cur;
+    }
+
+    if (update) {
+        if (save_baseline(path, lines, n) != 0) {
+            fprintf(stderr, "perf_regress: cannot write %s\n", path);
+            return 2;
+        }
+        printf("baseline updated: %s\n", path);
+        return 0;
+    }
+
+    printf("%s\n", failed ? "PERFORMANCE REGRESSION" : "all metrics within baseline");
+    free(ctx.msg);
+    return failed;
+}
@@ -22,10 +22,23 @@
 #define SM2_NULL_PTR       -1 /* 空指针错误 */
 #define SM2_INVALID_SIG    -2 /* 无效签名 */
 #define SM2_INVALID_CIPHER -3 /* 无效密文 */
+#define SM2_INVALID_KEY    -4 /* 无效密钥或编码 */
+#define SM2_INVALID_ID     -5 /* 用户标识过长 */
+#define SM2_INTERNAL_ERROR -6 /* 内存分配失败 */
+
+#define SM2_MAX_ID_LEN 8191 /* 用户标识最大长度（字节），ENTL为16位比特长度 */
+
+/* 紧凑编码长度（字节） */
+#define SM2_SCALAR_SIZE         32 /* 私钥与签名分量（大端） */
+#define SM2_SIG_SIZE            64 /* 签名 r || s */
+#define SM2_PUB_SIZE            65 /* 未压缩公钥 04 || x || y */
+#define SM2_PUB_COMPRESSED_SIZE 33 /* 压缩公钥 02/03 || x */
 
 /* SM2私钥结构 */
 typedef struct {
-    bn_t d; /* 私钥 */
+    bn_t d;                       /* 私钥 */
+    point p;                      /* 对应的公钥 dG（计算Z时使用） */
+    uint8_t chk[SM3_DIGEST_SIZE]; /* p的校验值，由构造私钥的函数写入；不匹配时签名前由d重新计算公钥 */
 } SM2_PRI_KEY;
 
 /* SM2公钥结构 */
@@ -48,19 +61,48 @@ typedef struct {
  */
 int SM2_GenerateKeyPair(SM2_PRI_KEY *pri_key, SM2_PUB_KEY *pub_key, group *g);
 
+/**
+ * @brief 批量生成SM2密钥对：一次读取全部随机数，基点预计算表共用，标量乘结果留在Jacobian坐标，
+ *        每128个公钥共用一次求逆转为仿射点；私钥在[1, n - 2]内
+ * @param pri_keys 私钥数组（count个）
+ * @param pub_keys 公钥数组（count个）
+ * @param count    密钥对个数
+ * @param g        椭圆曲线参数
+ * @param threads  线程数（小于1时按1处理，调用线程也参与计算；线程创建失败时其任务改由调用线程完成）
+ * @return 错误码，内存分配失败返回SM2_INTERNAL_ERROR（此时没有输出任何密钥）
+ */
+int SM2_GenerateKeyPairs(SM2_PRI_KEY *pri_keys, SM2_PUB_KEY *pub_keys, size_t count, group *g, int threads);
+
 /**
  * @brief SM2数字签名
- * @param pri_key 私钥
+ * @param pri_key 私钥（由SM2_GenerateKeyPair(s)或SM2_DecodePriKey构造时直接使用其中的公钥；
+ *                只设置了d时每次签名多做一次标量乘由d计算公钥）
  * @param g       椭圆曲线参数
  * @param msg     待签名消息
  * @param mlen    消息长度
  * @param id      用户标识
  * @param entl    用户标识长度
  * @param sig     签名
- * @return 错误码
+ * @return 错误码，私钥不在[1, n - 2]内返回SM2_INVALID_KEY
  */
 int SM2_Sign(SM2_PRI_KEY *pri_key, group *g, const uint8_t *msg, size_t mlen, uint8_t *id, size_t entl, SM2_SIG *sig);
 
+/**
+ * @brief 同一私钥对多条消息批量签名：Z与(1 + da)^-1只计算一次，各消息的e由多缓冲区SM3并行计算，
+ *        kG共用基点预计算表并留在Jacobian坐标，每64个签名共用一次求逆得到x1
+ * @param pri_key 私钥（公钥p的要求同SM2_Sign）
+ * @param g       椭圆曲线参数
+ * @param msgs    待签名消息数组
+ * @param mlens   消息长度数组
+ * @param count   消息条数
+ * @param id      用户标识
+ * @param entl    用户标识长度
+ * @param sigs    输出签名数组（count个）
+ * @return 错误码，消息指针为NULL（且长度不为0）返回SM2_NULL_PTR，私钥不在[1, n - 2]内返回SM2_INVALID_KEY
+ */
+int SM2_SignBatch(SM2_PRI_KEY *pri_key, group *g, const uint8_t *const msgs[], const size_t mlens[], size_t count,
+                  uint8_t *id, size_t entl, SM2_SIG sigs[]);
+
 /**
  * @brief SM2签名验证
  * @param pub_key 公钥
@@ -73,6 +115,170 @@ int SM2_Sign(SM2_PRI_KEY *pri_key, group *g, const uint8_t *msg, size_t mlen, ui
 int SM2_Verify(SM2_PUB_KEY *pub_key, group *g, const uint8_t *msg, size_t mlen, uint8_t *id, size_t entl,
                const SM2_SIG *sig);
 
+/**
+ * @brief 计算用户杂凑值Z = H(ENTL || ID || a || b || xG || yG || xA || yA)，各坐标为32字节大端
+ * @param z    输出杂凑值
+ * @param g    椭圆曲线参数
+ * @param pub  用户公钥
+ * @param id   用户标识
+ * @param entl 用户标识长度（不超过SM2_MAX_ID_LEN）
+ * @return 错误码
+ */
+int SM2_ComputeZ(uint8_t z[SM3_DIGEST_SIZE], const group *g, const point *pub, const uint8_t *id, size_t entl);
+
+/**
+ * @brief 带缓存的Z计算：以(ID, 公钥)为键查找进程内的Z缓存，未命中时计算并写入
+ *        （签名与验签使用此函数；缓存假定所有调用使用同一组曲线参数，线程安全）
+ * @param z    输出杂凑值
+ * @param g    椭圆曲线参数
+ * @param pub  用户公钥
+ * @param id   用户标识
+ * @param entl 用户标识长度
+ * @return 错误码
+ */
+int SM2_ComputeZCached(uint8_t z[SM3_DIGEST_SIZE], const group *g, const point *pub, const uint8_t *id,
+                       size_t entl);
+
+/**
+ * @brief 清空Z缓存
+ */
+void SM2_ZCacheClear(void);
+
+/**
+ * @brief 对已计算好的消息杂凑值e = H(Z || M)签名（用于流式哈希大文件）
+ * @param pri_key 私钥（只使用d，Z中的公钥由调用方负责）
+ * @param g       椭圆曲线参数
+ * @param digest  消息杂凑值e
+ * @param sig     签名
+ * @return 错误码，私钥不在[1, n - 2]内返回SM2_INVALID_KEY
+ */
+int SM2_SignDigest(SM2_PRI_KEY *pri_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], SM2_SIG *sig);
+
+/**
+ * @brief 用已计算好的消息杂凑值e = H(Z || M)验证签名
+ * @param pub_key 公钥
+ * @param g       椭圆曲线参数
+ * @param digest  消息杂凑值e
+ * @param sig     待验证签名
+ * @return 错误码
+ */
+int SM2_VerifyDigest(SM2_PUB_KEY *pub_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], const SM2_SIG *sig);
+
+/**
+ * @brief 对消息杂凑值签名并输出恢复标识，使验证方可由(签名, e, 恢复标识)恢复公钥
+ * @param pri_key 私钥
+ * @param g       椭圆曲线参数
+ * @param digest  消息杂凑值e
+ * @param sig     签名
+ * @param recid   输出恢复标识（0-3）：第0位为kG的y坐标奇偶性，第1位表示kG的x坐标不小于n
+ * @return 错误码，私钥不在[1, n - 2]内返回SM2_INVALID_KEY
+ */
+int SM2_SignDigestRecoverable(SM2_PRI_KEY *pri_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], SM2_SIG *sig,
+                              int *recid);
+
+/**
+ * @brief 由签名、消息杂凑值与恢复标识恢复签名者公钥 P = t^-1(R - sG)，其中R的x坐标为(r - e) mod n（或再加n）
+ *        （e包含依赖公钥的Z，调用者用恢复出的公钥重新计算e或比对公钥指纹来确认身份）
+ * @param pub_key 输出公钥
+ * @param g       椭圆曲线参数
+ * @param digest  消息杂凑值e
+ * @param sig     签名
+ * @param recid   恢复标识（SM2_SignDigestRecoverable的输出）
+ * @return 错误码，签名分量越界或无法恢复时返回SM2_INVALID_SIG
+ */
+int SM2_RecoverPublicKey(SM2_PUB_KEY *pub_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], const SM2_SIG *sig,
+                         int recid);
+
+/**
+ * @brief 私钥编码为32字节大端整数
+ * @param out     输出缓冲区
+ * @param pri_key 私钥
+ * @return 错误码
+ */
+int SM2_EncodePriKey(uint8_t out[SM2_SCALAR_SIZE], const SM2_PRI_KEY *pri_key);
+
+/**
+ * @brief 从32字节大端整数解码私钥（要求1 <= d <= n - 2），并计算对应公钥
+ * @param pri_key 私钥
+ * @param g       椭圆曲线参数
+ * @param in      编码
+ * @return 错误码，超出范围返回SM2_INVALID_KEY
+ */
+int SM2_DecodePriKey(SM2_PRI_KEY *pri_key, const group *g, const uint8_t in[SM2_SCALAR_SIZE]);
+
+/**
+ * @brief 公钥编码为未压缩形式 04 || x || y
+ * @param out     输出缓冲区（65字节）
+ * @param pub_key 公钥
+ * @return 错误码
+ */
+int SM2_EncodePubKey(uint8_t out[SM2_PUB_SIZE], const SM2_PUB_KEY *pub_key);
+
+/**
+ * @brief 公钥编码为压缩形式 (02 | y的最低位) || x
+ * @param out     输出缓冲区（33字节）
+ * @param pub_key 公钥
+ * @return 错误码
+ */
+int SM2_EncodePubKeyCompressed(uint8_t out[SM2_PUB_COMPRESSED_SIZE], const SM2_PUB_KEY *pub_key);
+
+/**
+ * @brief 解码公钥并检查其在曲线上（压缩形式通过模平方根恢复y）
+ * @param pub_key 公钥
+ * @param g       椭圆曲线参数
+ * @param in      编码
+ * @param len     编码长度（SM2_PUB_SIZE或SM2_PUB_COMPRESSED_SIZE）
+ * @return 错误码，格式错误或不在曲线上返回SM2_INVALID_KEY
+ */
+int SM2_DecodePubKey(SM2_PUB_KEY *pub_key, const group *g, const uint8_t *in, size_t len);
+
+/**
+ * @brief 签名编码为 r || s（各32字节大端）
+ * @param out 输出缓冲区
+ * @param sig 签名
+ * @return 错误码
+ */
+int SM2_EncodeSig(uint8_t out[SM2_SIG_SIZE], const SM2_SIG *sig);
+
+/**
+ * @brief 从 r || s 解码签名（范围检查在验签时进行）
+ * @param sig 签名
+ * @param in  编码
+ * @return 错误码
+ */
+int SM2_DecodeSig(SM2_SIG *sig, const uint8_t in[SM2_SIG_SIZE]);
+
+/**
+ * @brief 使用紧凑编码的私钥签名，输出64字节签名
+ * @param pri     私钥编码（32字节）
+ * @param pub     对应的公钥编码（计算Z时使用，签名前以一次常数时间标量乘检查其等于dG）
+ * @param publen  公钥编码长度
+ * @param g       椭圆曲线参数
+ * @param msg     待签名消息
+ * @param mlen    消息长度
+ * @param id      用户标识
+ * @param entl    用户标识长度
+ * @param sig     输出签名 r || s
+ * @return 错误码，私钥越界、公钥无效或与私钥不匹配时返回SM2_INVALID_KEY
+ */
+int SM2_SignPacked(const uint8_t pri[SM2_SCALAR_SIZE], const uint8_t *pub, size_t publen, group *g,
+                   const uint8_t *msg, size_t mlen, uint8_t *id, size_t entl, uint8_t sig[SM2_SIG_SIZE]);
+
+/**
+ * @brief 使用紧凑编码的公钥与签名验签
+ * @param pub     公钥编码
+ * @param publen  公钥编码长度
+ * @param g       椭圆曲线参数
+ * @param msg     原始消息
+ * @param mlen    消息长度
+ * @param id      用户标识
+ * @param entl    用户标识长度
+ * @param sig     签名 r || s
+ * @return 错误码
+ */
+int SM2_VerifyPacked(const uint8_t *pub, size_t publen, group *g, const uint8_t *msg, size_t mlen, uint8_t *id,
+                     size_t entl, const uint8_t sig[SM2_SIG_SIZE]);
+
 /**
  * @brief SM2加密
  * @param pub_key 公钥
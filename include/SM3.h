@@ -9,6 +9,7 @@
 #define SM3_DIGEST_SIZE 32 /* SM3输出摘要长度（字节）*/
 #define SM3_BLOCK_SIZE  64 /* SM3分组长度（字节）*/
 #define SM3_STATE_WORDS 8  /* 状态寄存器数量 */
+#define SM3_EXPORT_SIZE 105 /* 导出状态长度：状态32 + 总长度8 + 缓冲长度1 + 缓冲区64（字节）*/
 
 /* 错误码定义 */
 #define SM3_SUCCESS        0  /* 成功 */
@@ -24,6 +25,18 @@ typedef struct {
     size_t block_len;                /* 缓冲区中有效数据长度（字节） */
 } SM3_CTX;
 
+/* HMAC-SM3密钥：每个密钥只计算一次的内外层初始状态 */
+typedef struct {
+    uint32_t istate[SM3_STATE_WORDS]; /* 吸收(K ^ ipad)后的状态 */
+    uint32_t ostate[SM3_STATE_WORDS]; /* 吸收(K ^ opad)后的状态 */
+} SM3_HMAC_KEY;
+
+/* HMAC-SM3上下文结构体 */
+typedef struct {
+    SM3_CTX ctx;                      /* 内层哈希上下文 */
+    uint32_t ostate[SM3_STATE_WORDS]; /* 外层初始状态 */
+} SM3_HMAC_CTX;
+
 /**
  * @brief 初始化SM3上下文
  * @param ctx SM3上下文指针
@@ -71,10 +84,117 @@ int SM3(const uint8_t *data, size_t len, uint8_t digest[SM3_DIGEST_SIZE]);
  */
 void SM3_Compress(uint32_t state[SM3_STATE_WORDS], const uint8_t block[SM3_BLOCK_SIZE]);
 
+/**
+ * @brief SM3多分组压缩（连续处理nblocks个消息分组，状态在分组间保留在寄存器中）
+ * @param state 当前状态（输入输出参数）
+ * @param data 消息分组（nblocks * 64字节，无需对齐）
+ * @param nblocks 分组数
+ */
+void SM3_CompressBlocks(uint32_t state[SM3_STATE_WORDS], const uint8_t *data, size_t nblocks);
+
 /**
  * @brief 填充消息
  * @param ctx SM3上下文指针
  */
 void SM3_PadMessage(SM3_CTX *ctx);
 
+/**
+ * @brief 复制SM3上下文（用于对公共前缀只哈希一次、之后分叉）
+ * @param dst 目标上下文
+ * @param src 源上下文
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Copy(SM3_CTX *dst, const SM3_CTX *src);
+
+/**
+ * @brief 导出SM3上下文为定长字节串（大端，含总长度与缓冲数据）
+ * @param ctx SM3上下文指针
+ * @param out 输出缓冲区（SM3_EXPORT_SIZE字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Export(const SM3_CTX *ctx, uint8_t out[SM3_EXPORT_SIZE]);
+
+/**
+ * @brief 从SM3_Export的输出恢复SM3上下文
+ * @param ctx SM3上下文指针
+ * @param in 导出的字节串（SM3_EXPORT_SIZE字节）
+ * @return 成功返回SM3_SUCCESS，数据不一致返回SM3_INVALID_LENGTH
+ */
+int SM3_Import(SM3_CTX *ctx, const uint8_t in[SM3_EXPORT_SIZE]);
+
+/**
+ * @brief 预计算HMAC-SM3密钥（每个密钥调用一次，之后每次HMAC省去两次压缩）
+ * @param hkey HMAC密钥结构指针
+ * @param key 密钥
+ * @param klen 密钥长度（超过64字节时先做SM3）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC_SetKey(SM3_HMAC_KEY *hkey, const uint8_t *key, size_t klen);
+
+/**
+ * @brief 清除HMAC-SM3密钥
+ * @param hkey HMAC密钥结构指针
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC_ClearKey(SM3_HMAC_KEY *hkey);
+
+/**
+ * @brief 以预计算的密钥初始化HMAC-SM3上下文
+ * @param ctx HMAC上下文指针
+ * @param hkey 预计算的HMAC密钥
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC_Init(SM3_HMAC_CTX *ctx, const SM3_HMAC_KEY *hkey);
+
+/**
+ * @brief 处理输入数据（可多次调用）
+ * @param ctx HMAC上下文指针
+ * @param data 输入数据指针
+ * @param len 输入数据长度（字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC_Update(SM3_HMAC_CTX *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief 生成HMAC值并清除上下文
+ * @param ctx HMAC上下文指针
+ * @param mac 输出缓冲区（32字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC_Final(SM3_HMAC_CTX *ctx, uint8_t mac[SM3_DIGEST_SIZE]);
+
+/**
+ * @brief 一次性计算HMAC-SM3
+ * @param hkey 预计算的HMAC密钥
+ * @param data 输入数据指针
+ * @param len 输入数据长度
+ * @param mac 输出缓冲区（32字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_HMAC(const SM3_HMAC_KEY *hkey, const uint8_t *data, size_t len, uint8_t mac[SM3_DIGEST_SIZE]);
+
+/**
+ * @brief 多缓冲区SM3：在SIMD通道中并行计算多条独立消息的哈希值
+ *        （AVX-512为16通道，AVX2为8通道，运行时检测CPU，不支持时退回标量实现）
+ * @param data 消息指针数组
+ * @param len 消息长度数组
+ * @param n 消息条数
+ * @param digest 输出摘要数组（n个）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_MultiBuffer(const uint8_t *const data[], const size_t len[], size_t n, uint8_t digest[][SM3_DIGEST_SIZE]);
+
+/**
+ * @brief 多缓冲区SM3：从已有上下文出发追加数据并输出摘要（上下文不被修改）
+ *        多条消息可指向同一上下文，用于共享前缀（如KDF中的Z与计数器）
+ * @param ctx 上下文指针数组
+ * @param data 追加数据指针数组
+ * @param len 追加数据长度数组
+ * @param n 消息条数
+ * @param digest 输出摘要数组（n个）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_MultiBufferFinal(const SM3_CTX *const ctx[], const uint8_t *const data[], const size_t len[], size_t n,
+                         uint8_t digest[][SM3_DIGEST_SIZE]);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef SM3_TREE_H
+#define SM3_TREE_H
+
+#include "SM3.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SM3树哈希（SM3-TREE）：用于超大文件的并行哈希，与普通SM3结果不同，
+ * 只能在双方约定使用该模式时使用。定义如下：
+ *   1. 输入按SM3_TREE_LEAF_SIZE字节切分为叶子，最后一个叶子可以较短，空输入视为一个空叶子；
+ *   2. 叶子摘要  L_i  = SM3(0x00 || 叶子数据)；
+ *   3. 内部节点  N    = SM3(0x01 || 左子树摘要 || 右子树摘要)，
+ *      k个叶子的树在小于k的最大2的幂处划分左右子树（左子树为满二叉树）；
+ *   4. 最终摘要       = SM3(0x02 || 根节点摘要 || 输入总长度（64位大端，字节）)。
+ */
+
+/* 常量定义 */
+#define SM3_TREE_LEAF_SIZE ((size_t)1 << 20) /* 叶子长度（字节）*/
+#define SM3_TREE_MAX_DEPTH 64                /* 子树栈深度上限 */
+
+/* SM3树哈希上下文结构体 */
+typedef struct {
+    SM3_CTX leaf;                                          /* 当前叶子的哈希上下文 */
+    size_t leaf_len;                                       /* 当前叶子已输入长度（字节） */
+    uint64_t leaves;                                       /* 已完成的叶子数 */
+    uint64_t total_len;                                    /* 已输入消息总长度（字节） */
+    uint8_t stack[SM3_TREE_MAX_DEPTH][SM3_DIGEST_SIZE];    /* 待合并的满子树摘要 */
+    size_t depth;                                          /* 栈中子树数量 */
+} SM3_TREE_CTX;
+
+/**
+ * @brief 初始化SM3树哈希上下文
+ * @param ctx SM3树哈希上下文指针
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Tree_Init(SM3_TREE_CTX *ctx);
+
+/**
+ * @brief 处理输入数据（可多次调用）
+ * @param ctx SM3树哈希上下文指针
+ * @param data 输入数据指针
+ * @param len 输入数据长度（字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Tree_Update(SM3_TREE_CTX *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief 生成最终树哈希值
+ * @param ctx SM3树哈希上下文指针
+ * @param digest 输出摘要缓冲区（至少32字节）
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Tree_Final(SM3_TREE_CTX *ctx, uint8_t digest[SM3_DIGEST_SIZE]);
+
+/**
+ * @brief 多线程一次性计算SM3树哈希值（每个线程内再用多缓冲区SM3并行处理叶子）
+ * @param data 输入数据指针
+ * @param len 输入数据长度
+ * @param threads 线程数（小于等于1时在调用线程中计算；无法创建的线程的工作由调用线程完成）
+ * @param digest 输出摘要缓冲区
+ * @return 成功返回SM3_SUCCESS，失败返回错误码
+ */
+int SM3_Tree(const uint8_t *data, size_t len, int threads, uint8_t digest[SM3_DIGEST_SIZE]);
+
+#endif
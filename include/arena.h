@@ -0,0 +1,86 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 临时内存区：在预留的一块内存上按栈的方式分配，分配时不做初始化，按后进先出的顺序整体释放。
+ * 典型用法：
+ *     arena *ar = arena_thread();
+ *     size_t mark = arena_mark(ar);
+ *     ... arena_alloc(ar, n) ...
+ *     arena_release(ar, mark);
+ * 每个线程有一个默认的内存区（arena_thread()），批量接口也可以用arena_init()把整批运算的工作集
+ * 放在调用者提供的一块内存中。空间不足时调用abort()。
+ */
+
+/* 分配粒度与对齐（字节） */
+#define ARENA_ALIGN       64
+
+/* 线程默认内存区的大小（字节） */
+#define ARENA_THREAD_SIZE (64 * 1024)
+
+typedef struct {
+    uint8_t *buf; /* 起始地址 */
+    size_t size;  /* 容量（字节） */
+    size_t top;   /* 已分配的字节数 */
+} arena;
+
+/**
+ * @brief 在调用者提供的内存上建立内存区
+ * @param a 内存区
+ * @param buf 内存起始地址（会向上对齐到ARENA_ALIGN）
+ * @param size 内存大小（字节）
+ */
+void arena_init(arena *a, void *buf, size_t size);
+
+/**
+ * @brief 当前线程的默认内存区
+ * @return 内存区
+ */
+arena *arena_thread(void);
+
+/**
+ * @brief 空间不足时打印用量并终止程序（由arena_alloc()调用）
+ * @param a 内存区
+ * @param size 请求的字节数
+ */
+void arena_overflow(const arena *a, size_t size);
+
+/**
+ * @brief 从内存区分配size字节（按ARENA_ALIGN对齐，内容未初始化）
+ * @param a 内存区
+ * @param size 字节数
+ * @return 内存地址
+ */
+static inline void *arena_alloc(arena *a, size_t size) {
+    size_t n = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    void *p;
+
+    if (n > a->size - a->top)
+        arena_overflow(a, size);
+    p = a->buf + a->top;
+    a->top += n;
+    return p;
+}
+
+/**
+ * @brief 记录当前分配位置
+ * @param a 内存区
+ * @return 位置标记，交给arena_release()
+ */
+static inline size_t arena_mark(const arena *a) {
+    return a->top;
+}
+
+/**
+ * @brief 释放标记之后分配的全部内存
+ * @param a 内存区
+ * @param mark arena_mark()的返回值
+ */
+static inline void arena_release(arena *a, size_t mark) {
+    a->top = mark;
+}
+
+#endif
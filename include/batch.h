@@ -0,0 +1,109 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "arena.h"
+#include "fp.h"
+#include "point.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 批量点的结构数组布局：N个点的X、Y、Z坐标各存为一块64字节对齐的连续分量数组，
+ * 按分量优先排列——第j个点的第i个64位分量位于 x[i * stride + j]，stride为N向上取整到BATCH_LANES的倍数。
+ * 同一分量的相邻点在内存中相邻，批量域运算按BATCH_LANES个点一组处理，便于向量化。
+ * 坐标为Montgomery形式的Jacobian坐标：(X, Y, Z)表示仿射点(X/Z^2, Y/Z^3)，Z = 0表示无穷远点。
+ * 每个点占3 * 4 * 8 = 96字节（point结构体约为其6倍，且两坐标相距数百字节）。
+ */
+
+/* 一组并行处理的点数（一个AVX-512寄存器的64位通道数） */
+#define BATCH_LANES 8
+
+typedef struct {
+    size_t n;      /* 点数 */
+    size_t stride; /* 每个分量行的长度（点数向上取整到BATCH_LANES） */
+    uint64_t *x;   /* X坐标，FP_DIGS行，每行stride个分量 */
+    uint64_t *y;   /* Y坐标 */
+    uint64_t *z;   /* Z坐标 */
+} point_batch;
+
+/**
+ * @brief n个点的批量布局所需的内存（字节，含对齐余量），用于预先确定内存区大小
+ * @param n 点数
+ * @return 字节数
+ */
+size_t point_batch_bytes(size_t n);
+
+/**
+ * @brief 从内存区一次分配n个点的坐标数组（内容未初始化，补齐的通道清零）
+ * @param b 输出批量
+ * @param ar 内存区，释放由调用者通过arena_release()完成
+ * @param n 点数
+ */
+void point_batch_init(point_batch *b, arena *ar, size_t n);
+
+/**
+ * @brief 把仿射点数组写入批量（Z = 1，无穷远点Z = 0）
+ * @param b 批量（点数为n）
+ * @param pts 仿射点数组
+ * @param ctx 坐标域的上下文
+ */
+void point_batch_pack(point_batch *b, const point *pts, const fp_ctx *ctx);
+
+/**
+ * @brief 把批量转回仿射点数组，全部Z坐标共用一次求逆
+ * @param pts 输出仿射点数组（n个）
+ * @param b 批量
+ * @param ctx 坐标域的上下文（模数须为素数）
+ * @param ar 临时空间（约n * 64字节）取自此内存区，返回前释放
+ */
+void point_batch_unpack(point *pts, const point_batch *b, const fp_ctx *ctx, arena *ar);
+
+/**
+ * @brief 读取批量中第j个元素（分量行长度为stride的一列）
+ */
+static inline void fp_vec_get(fp_t c, const uint64_t *v, size_t stride, size_t j) {
+    for (int i = 0; i < FP_DIGS; i++)
+        c[i] = v[i * stride + j];
+}
+
+/**
+ * @brief 写入批量中第j个元素
+ */
+static inline void fp_vec_set(uint64_t *v, size_t stride, size_t j, const fp_t a) {
+    for (int i = 0; i < FP_DIGS; i++)
+        v[i * stride + j] = a[i];
+}
+
+/*
+ * 批量域运算：a、b、c均为分量优先排列的n个元素（FP_DIGS行，每行stride个分量，stride为BATCH_LANES的倍数），
+ * 逐元素计算，按BATCH_LANES一组处理（补齐的通道也参与计算）。c可以与a或b相同。
+ */
+
+/**
+ * @brief c[j] = a[j] + b[j] mod m
+ */
+void fp_vec_add(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx);
+
+/**
+ * @brief c[j] = a[j] - b[j] mod m
+ */
+void fp_vec_sub(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx);
+
+/**
+ * @brief c[j] = a[j] * b[j] * R^-1 mod m
+ */
+void fp_vec_mul(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx);
+
+/**
+ * @brief c[j] = sel[j] ? b[j] : a[j]，不含分支
+ * @param sel 每个元素的选择位（0或1）
+ */
+void fp_vec_select(uint64_t *c, const uint64_t *a, const uint64_t *b, const uint8_t *sel, size_t n, size_t stride);
+
+/**
+ * @brief c[j] = a[j]^-1 mod m，n个元素共用一次求逆（Montgomery技巧，0的逆为0）
+ * @param ar 临时空间（约n * 32字节）取自此内存区，返回前释放
+ */
+void fp_vec_inv(uint64_t *c, const uint64_t *a, size_t n, size_t stride, const fp_ctx *ctx, arena *ar);
+
+#endif
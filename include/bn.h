@@ -2,6 +2,7 @@
 #define BN_H
 
 #include "SM3.h"
+#include "arena.h"
 #include <stdint.h>
 
 #define WSIZE     64
@@ -61,11 +62,24 @@ typedef struct {
 
 typedef bn_st bn_t[1];
 
+/* temporary carved from arena A: only the header is set (value 0), digits are not cleared */
+static inline bn_st *bn_tmp(arena *a) {
+    bn_st *t = (bn_st *)arena_alloc(a, sizeof(bn_st));
+    t->alloc = BN_SIZE;
+    t->used = 1;
+    t->sign = BN_POS;
+    t->dp[0] = 0;
+    return t;
+}
+
 /* utils */
 void bn_make(bn_t a, size_t digits);
 
 void bn_trim(bn_t a);
 
+/* fill buf with len random bytes from the operating system (one read for bulk use) */
+void bn_rand_bytes(uint8_t *buf, size_t len);
+
 void bn_rand(bn_t a, int sign, size_t bits);
 
 void bn_rand_mod(bn_t a, const bn_t m);
@@ -96,7 +110,14 @@ void bn_from_digest(bn_t a, const uint8_t digest[SM3_DIGEST_SIZE]);
 
 void bn_from_hex(bn_t a, const char *hex);
 
-char *bn_to_hex(const bn_t a);
+/* hex[0..len) = a as upper-case hex with a terminating NUL; returns the length, or 0 if len is too small */
+size_t bn_to_hex(char *hex, size_t len, const bn_t a);
+
+/* a = big-endian bin[0..len), no allocation */
+void bn_from_bytes(bn_t a, const uint8_t *bin, size_t len);
+
+/* bin[0..len) = a as big-endian, zero-padded on the left (a must fit in len bytes) */
+void bn_to_bytes(uint8_t *bin, size_t len, const bn_t a);
 
 void bn_print(bn_t a);
 
@@ -108,12 +129,18 @@ void bn_add(bn_t c, const bn_t a, const bn_t b);
 /* c = a + (dig_t)b */
 void bn_add_dig(bn_t c, const bn_t a, dig_t b);
 
+/* c = a - (dig_t)b */
+void bn_sub_dig(bn_t c, const bn_t a, dig_t b);
+
 /* c = a - b */
 void bn_sub(bn_t c, const bn_t a, const bn_t b);
 
 /* c = a * b */
 void bn_mul(bn_t c, const bn_t a, const bn_t b);
 
+/* c = a^2 (Comba squaring, each cross product computed once) */
+void bn_sqr(bn_t c, const bn_t a);
+
 /* c = a / b, d = a % b */
 void bn_div(bn_t c, bn_t d, const bn_t a, const bn_t b);
 
@@ -123,13 +150,28 @@ void bn_mod(bn_t c, const bn_t a, const bn_t m);
 /* c = a^-1 mod b */
 void bn_mod_inv(bn_t c, const bn_t a, const bn_t b);
 
-/* c = (a + b) mod m */
+/* c = (a + b) mod m; for a, b in [0, m) one masked subtraction, otherwise a division */
 void bn_mod_add(bn_t c, const bn_t a, const bn_t b, const bn_t m);
 
-/* c = (a - b) mod m */
+/* c = (a - b) mod m; for a, b in [0, m) one masked addition, otherwise a division */
 void bn_mod_sub(bn_t c, const bn_t a, const bn_t b, const bn_t m);
 
+/* c = 2a mod m */
+void bn_mod_dbl(bn_t c, const bn_t a, const bn_t m);
+
+/* c = 3a mod m */
+void bn_mod_tpl(bn_t c, const bn_t a, const bn_t m);
+
 /* c = a * b mod m */
 void bn_mod_mul(bn_t c, const bn_t a, const bn_t b, const bn_t m);
 
+/* c = a^2 mod m */
+void bn_mod_sqr(bn_t c, const bn_t a, const bn_t m);
+
+/* c = a^e mod m, fixed 4-bit window (e >= 0) */
+void bn_mod_exp(bn_t c, const bn_t a, const bn_t e, const bn_t m);
+
+/* c = sqrt(a) mod p for p = 3 mod 4; returns 1 if a is a square, 0 otherwise */
+int bn_mod_sqrt(bn_t c, const bn_t a, const bn_t p);
+
 #endif
\ No newline at end of file
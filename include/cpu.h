@@ -0,0 +1,24 @@
+#ifndef CPU_H
+#define CPU_H
+
+/* CPU特性标志 */
+#define CPU_AVX2       (1u << 0) /* AVX2 */
+#define CPU_AVX512F    (1u << 1) /* AVX-512 Foundation */
+#define CPU_AVX512BW   (1u << 2) /* AVX-512 字节/字指令 */
+#define CPU_AVX512IFMA (1u << 3) /* AVX-512 52位整数乘加 */
+#define CPU_BMI2       (1u << 4) /* BMI2（MULX） */
+#define CPU_ADX        (1u << 5) /* ADX（ADCX/ADOX） */
+
+/**
+ * @brief 获取当前CPU（及操作系统）支持的指令集特性
+ * @return CPU_*标志的组合，首次调用时检测并缓存
+ */
+unsigned int cpu_features(void);
+
+/**
+ * @brief 屏蔽指定的CPU特性，强制走回退路径（用于测试与基准对比）
+ * @param features 需要屏蔽的CPU_*标志
+ */
+void cpu_disable(unsigned int features);
+
+#endif
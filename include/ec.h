@@ -2,6 +2,7 @@
 #define EC_H
 
 #include "bn.h"
+#include "fp.h"
 #include "point.h"
 
 typedef struct {
@@ -10,6 +11,11 @@ typedef struct {
     bn_t b;
     point g;
     bn_t n;
+    fp_ctx fn; /* 阶n的定长运算上下文，用于签名方程 */
+    fp_ctx fp; /* 域p的定长运算上下文，用于ecp.h中的Jacobian点运算 */
+    fp_t ma;   /* a的Montgomery形式（模p） */
+    int a_m3;  /* a = p - 3时为1，倍点可少做乘法 */
+    uint8_t tag[SM3_DIGEST_SIZE]; /* SM3(a || b || xG || yG)，区分不同曲线（如Z缓存的键） */
 } group;
 
 void create_group(group *g, const char *p_hex, const char *a_hex, const char *b_hex, const char *gx_hex,
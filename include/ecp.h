@@ -0,0 +1,133 @@
+#ifndef ECP_H
+#define ECP_H
+
+#include "bn.h"
+#include "ec.h"
+#include "fp.h"
+#include "point.h"
+
+/*
+ * Jacobian坐标的点运算：坐标为模p的Montgomery形式（group.fp），(X, Y, Z)表示仿射点(X/Z^2, Y/Z^3)，Z = 0表示无穷远点。
+ * 运算中不求逆，只在转回仿射点（ecp_get_point）时求逆一次。要求曲线的阶n为素数（余因子为1）。
+ */
+
+/* 标量乘的窗口宽度：常数时间路径用W位带符号奇数字（表长2^(W-1)），变时路径用宽度W的wNAF（表长2^(W-2)） */
+#define ECP_W 5
+
+/* 常数时间路径的预计算表长（奇数倍1, 3, ..., 2^W - 1） */
+#define ECP_CT_TBL (1 << (ECP_W - 1))
+
+typedef struct {
+    fp_t x;
+    fp_t y;
+    fp_t z;
+} ecp;
+
+/**
+ * @brief 仿射点转为Jacobian坐标（(0, 0)视为无穷远点）
+ * @param r 输出点
+ * @param a 仿射点（坐标在[0, p)内）
+ * @param g 曲线参数
+ */
+void ecp_set_point(ecp *r, const point *a, const group *g);
+
+/**
+ * @brief 由x坐标与y的奇偶性得到曲线上的点（Z = 1），y由定长模平方根求得（要求p = 3 mod 4）
+ * @param r 输出点
+ * @param x x坐标
+ * @param y_odd y的最低位
+ * @param g 曲线参数
+ * @return 成功返回1，x不在[0, p)内或曲线上没有该x（或奇偶性）的点时返回0
+ */
+int ecp_set_x(ecp *r, const bn_t x, int y_odd, const group *g);
+
+/**
+ * @brief Jacobian坐标转回仿射点（一次求逆，无穷远点转为(0, 0)）
+ * @param r 输出仿射点
+ * @param a Jacobian点
+ * @param g 曲线参数
+ */
+void ecp_get_point(point *r, const ecp *a, const group *g);
+
+/**
+ * @brief 判断是否为无穷远点
+ * @return 是返回1，否则返回0
+ */
+static inline int ecp_is_infty(const ecp *a) {
+    return fp_is_zero(a->z);
+}
+
+/**
+ * @brief 不求逆地判断a的仿射x坐标是否等于x，即比较X与xZ^2
+ * @param a Jacobian点
+ * @param x 待比较的值（在[0, p)内）
+ * @param g 曲线参数
+ * @return 相等返回1，否则（包括a为无穷远点）返回0
+ */
+int ecp_x_equals(const ecp *a, const bn_t x, const group *g);
+
+/**
+ * @brief r = 2a，不含分支（a = -3时用3M + 5S的公式，否则2M + 8S）
+ */
+void ecp_dbl(ecp *r, const ecp *a, const group *g);
+
+/**
+ * @brief r = a + b，处理无穷远点、a = b与a = -b的情况（按情况分支，只用于公开的点）
+ */
+void ecp_add(ecp *r, const ecp *a, const ecp *b, const group *g);
+
+/**
+ * @brief r = ka，常数时间：运算序列与内存访问只依赖n，不依赖k与a的值
+ * @param r 输出点
+ * @param a 阶为n的点（不能是无穷远点）
+ * @param k 标量（不在[0, n)内时先约简）
+ * @param g 曲线参数
+ */
+void ecp_mul_ct(ecp *r, const ecp *a, const bn_t k, const group *g);
+
+/**
+ * @brief ecp_mul_ct的预计算表 t[j] = (2j + 1)a，同一个点做多次标量乘（如批量生成密钥）时只需计算一次
+ * @param t 输出表
+ * @param a 阶为n的点（不能是无穷远点）
+ * @param g 曲线参数
+ */
+void ecp_mul_ct_table(ecp t[ECP_CT_TBL], const ecp *a, const group *g);
+
+/**
+ * @brief 用预计算表做常数时间标量乘 r = ka（与ecp_mul_ct相同）
+ * @param r 输出点
+ * @param t ecp_mul_ct_table的输出
+ * @param k 标量（不在[0, n)内时先约简）
+ * @param g 曲线参数
+ */
+void ecp_mul_ct_tab(ecp *r, const ecp t[ECP_CT_TBL], const bn_t k, const group *g);
+
+/**
+ * @brief r = ka + lb，宽度ECP_W的wNAF交错计算，运行时间依赖k与l，只用于公开的标量（如验签）
+ * @param r 输出点
+ * @param a 第一个点
+ * @param k 第一个标量（k >= 0，k < 2^256）
+ * @param b 第二个点（为NULL时只计算ka）
+ * @param l 第二个标量（b为NULL时忽略）
+ * @param g 曲线参数
+ */
+void ecp_mul2_vartime(ecp *r, const ecp *a, const bn_t k, const ecp *b, const bn_t l, const group *g);
+
+/**
+ * @brief 仿射点的常数时间标量乘 r = ka（ecp_mul_ct的包装）
+ */
+void ecp_mul_point_ct(point *r, const point *a, const bn_t k, const group *g);
+
+/**
+ * @brief 共Z的Montgomery阶梯计算ka的坐标（用于共享密钥，如解密中的dB·C1）：每一位固定做一次共Z加减与一次共Z加法，
+ *        只保存两个点的X、Y，最后一次求逆同时恢复Z；运算序列只依赖n
+ * @param x 输出ka的x坐标
+ * @param y 输出ka的y坐标（为NULL时只输出x）
+ * @param a 阶为n的仿射点（不能是无穷远点）
+ * @param k 标量（不在[0, n)内时先约简）
+ * @param g 曲线参数
+ * @return 成功返回1，ka为无穷远点（k ≡ 0 mod n）时返回0
+ */
+int ecp_ladder(bn_t x, bn_t y, const point *a, const bn_t k, const group *g);
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef FP_H
+#define FP_H
+
+#include "bn.h"
+#include <stdint.h>
+
+/*
+ * 定长256位模运算：元素为4个64位分量（小端）的Montgomery形式 aR mod m，R = 2^256。
+ * 模数m为奇数且小于2^256；除fp_inv要求m为素数外不依赖模数的特殊形式。
+ * 运算结果总在[0, m)内，不做堆分配，运算时间与操作数的值无关（fp_exp与指数的值无关，指数长度除外；加法链只依赖模数）。
+ */
+
+#define FP_DIGS 4
+
+typedef uint64_t fp_t[FP_DIGS];
+
+/* 加法链的最大乘法步数（窗口宽度不小于4，256位指数至多64个窗口） */
+#define FP_CHAIN_MAX 64
+
+/*
+ * 固定指数的加法链：预先按滑动窗口分解指数，运行时只做平方与按固定下标的乘法。
+ * 表中第i项为a^(2i + 1)；步骤与底数无关，只依赖（公开的）指数。
+ */
+typedef struct {
+    uint8_t w;                  /* 窗口宽度，表长2^(w - 1) */
+    uint8_t n;                  /* 乘法步数，0表示指数为0 */
+    uint16_t tail;              /* 最后一步之后的平方次数 */
+    uint16_t sqr[FP_CHAIN_MAX]; /* 第i步先平方sqr[i]次（第0步不平方）…… */
+    uint8_t idx[FP_CHAIN_MAX];  /* ……再乘以表中第idx[i]项 */
+} fp_chain;
+
+/* 模数相关的预计算值 */
+typedef struct {
+    fp_t m;          /* 模数 */
+    fp_t one;        /* R mod m，即1的Montgomery形式 */
+    fp_t rr;         /* R^2 mod m，用于转入Montgomery形式 */
+    uint64_t n0;     /* -m^-1 mod 2^64 */
+    fp_chain inv;    /* 指数m - 2，用于fp_inv */
+    fp_chain sqrt;   /* 指数(m + 1) / 4（m = 3 mod 4时），用于fp_sqrt */
+} fp_ctx;
+
+/**
+ * @brief 由模数建立运算上下文
+ * @param ctx 输出上下文
+ * @param m 模数（奇数，0 < m < 2^256）
+ */
+void fp_ctx_init(fp_ctx *ctx, const bn_t m);
+
+/**
+ * @brief 大整数约简后转入Montgomery形式
+ * @param c 输出元素
+ * @param a 输入（0 <= a < 2^256，可以不小于m）
+ * @param ctx 上下文
+ */
+void fp_from_bn(fp_t c, const bn_t a, const fp_ctx *ctx);
+
+/**
+ * @brief Montgomery形式转回大整数
+ * @param c 输出大整数
+ * @param a 输入元素
+ * @param ctx 上下文
+ */
+void fp_to_bn(bn_t c, const fp_t a, const fp_ctx *ctx);
+
+/**
+ * @brief c = a
+ */
+static inline void fp_copy(fp_t c, const fp_t a) {
+    for (int i = 0; i < FP_DIGS; i++)
+        c[i] = a[i];
+}
+
+/**
+ * @brief 判断a是否为0
+ * @return 是返回1，否则返回0
+ */
+static inline int fp_is_zero(const fp_t a) {
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+/**
+ * @brief 判断a与b是否相等
+ * @return 相等返回1，否则返回0
+ */
+static inline int fp_equal(const fp_t a, const fp_t b) {
+    return ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3])) == 0;
+}
+
+/**
+ * @brief c = a + b mod m
+ */
+void fp_add(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx);
+
+/**
+ * @brief c = a - b mod m
+ */
+void fp_sub(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx);
+
+/**
+ * @brief c = 2a mod m
+ */
+void fp_dbl(fp_t c, const fp_t a, const fp_ctx *ctx);
+
+/**
+ * @brief c = 3a mod m
+ */
+void fp_tpl(fp_t c, const fp_t a, const fp_ctx *ctx);
+
+/**
+ * @brief c = a * b * R^-1 mod m（Montgomery乘法）
+ */
+void fp_mul(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx);
+
+/**
+ * @brief c = a^2 * R^-1 mod m
+ */
+void fp_sqr(fp_t c, const fp_t a, const fp_ctx *ctx);
+
+/**
+ * @brief c = a^(2^k) mod m（连续平方k次）
+ */
+void fp_sqr_n(fp_t c, const fp_t a, int k, const fp_ctx *ctx);
+
+/**
+ * @brief c = a^e mod m
+ * @param c 输出元素
+ * @param a 底数（Montgomery形式）
+ * @param e 指数（普通整数，4个64位分量，小端）
+ * @param ctx 上下文
+ */
+void fp_exp(fp_t c, const fp_t a, const fp_t e, const fp_ctx *ctx);
+
+/**
+ * @brief 为固定指数建立加法链（在可选的窗口宽度中取乘法次数最少者）
+ * @param ch 输出加法链
+ * @param e 指数（普通整数，4个64位分量，小端）
+ */
+void fp_chain_init(fp_chain *ch, const fp_t e);
+
+/**
+ * @brief c = a^e mod m，e为建立加法链时的指数
+ * @param c 输出元素
+ * @param a 底数（Montgomery形式）
+ * @param ch 加法链
+ * @param ctx 上下文
+ */
+void fp_exp_chain(fp_t c, const fp_t a, const fp_chain *ch, const fp_ctx *ctx);
+
+/**
+ * @brief c = a^-1 mod m，以a^(m-2)计算（m须为素数，a = 0时结果为0）
+ */
+void fp_inv(fp_t c, const fp_t a, const fp_ctx *ctx);
+
+/**
+ * @brief c = sqrt(a) mod m，以a^((m+1)/4)计算（m须为素数且m = 3 mod 4）
+ * @return a为平方剩余返回1（c为其一个平方根），否则返回0
+ */
+int fp_sqrt(fp_t c, const fp_t a, const fp_ctx *ctx);
+
+#endif
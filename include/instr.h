@@ -0,0 +1,106 @@
+#ifndef INSTR_H
+#define INSTR_H
+
+#include <stdint.h>
+
+/*
+ * 运算计数与阶段计时（编译期开关）：定义SM2_INSTRUMENT（CMake选项-DSM2_INSTRUMENT=ON）时，
+ * 各层运算计入线程局部计数器；未定义时下面的宏展开为空，没有任何运行时开销，
+ * instr_snapshot()返回全零。
+ */
+
+/* 计数器编号 */
+typedef enum {
+    INSTR_MOD_MUL,      /* 模乘 */
+    INSTR_MOD_SQR,      /* 模平方 */
+    INSTR_MOD_INV,      /* 模逆 */
+    INSTR_BN_DIV,       /* bn_div调用（含bn_mod） */
+    INSTR_BN_NEW,       /* bn_new清零 */
+    INSTR_POINT_DBL,    /* 点倍 */
+    INSTR_POINT_ADD,    /* 点加 */
+    INSTR_SM3_COMPRESS, /* SM3压缩（分组数） */
+    INSTR_COUNTERS
+} instr_counter;
+
+/* SM2计时阶段编号 */
+typedef enum {
+    INSTR_STAGE_Z,     /* 计算Z */
+    INSTR_STAGE_E,     /* 计算e = H(Z || M) */
+    INSTR_STAGE_MUL,   /* 标量乘 */
+    INSTR_STAGE_FINAL, /* 标量乘之后的模运算与检查 */
+    INSTR_STAGES
+} instr_stage;
+
+/* 计数器快照 */
+typedef struct {
+    uint64_t count[INSTR_COUNTERS];
+    uint64_t stage_cycles[INSTR_STAGES]; /* 各阶段累计周期数（x86为TSC，其他平台为纳秒） */
+    uint64_t stage_calls[INSTR_STAGES];  /* 各阶段进入次数 */
+} instr_counters;
+
+#ifdef SM2_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define instr_cycles() __rdtsc()
+#else
+#include <time.h>
+static inline uint64_t instr_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+extern _Thread_local instr_counters instr_tls;
+
+#define INSTR_COUNT(C)          (instr_tls.count[C]++)
+#define INSTR_ADD(C, N)         (instr_tls.count[C] += (N))
+#define INSTR_STAGE_BEGIN(S)    uint64_t _instr_##S = instr_cycles()
+#define INSTR_STAGE_END(S)                                                                                             \
+    do {                                                                                                               \
+        instr_tls.stage_cycles[S] += instr_cycles() - _instr_##S;                                                      \
+        instr_tls.stage_calls[S]++;                                                                                    \
+    } while (0)
+
+#else
+
+#define INSTR_COUNT(C)          ((void)0)
+#define INSTR_ADD(C, N)         ((void)0)
+#define INSTR_STAGE_BEGIN(S)    ((void)0)
+#define INSTR_STAGE_END(S)      ((void)0)
+
+#endif
+
+/**
+ * @brief 库是否以SM2_INSTRUMENT编译
+ * @return 是返回1，否则返回0
+ */
+int instr_enabled(void);
+
+/**
+ * @brief 读取当前线程的计数器
+ * @param out 输出快照
+ */
+void instr_snapshot(instr_counters *out);
+
+/**
+ * @brief 清零当前线程的计数器
+ */
+void instr_reset(void);
+
+/**
+ * @brief 计数器名称
+ * @param c 计数器编号
+ * @return 名称字符串
+ */
+const char *instr_counter_name(instr_counter c);
+
+/**
+ * @brief 阶段名称
+ * @param s 阶段编号
+ * @return 名称字符串
+ */
+const char *instr_stage_name(instr_stage s);
+
+#endif
@@ -14,6 +14,10 @@ int point_equals(const point *a, const point *b);
 
 int point_is_infty(const point *a);
 
+int point_on_curve(const point *g, const bn_t p, const bn_t a, const bn_t b);
+
+int point_decompress(point *c, const bn_t x, int y_odd, const bn_t p, const bn_t a, const bn_t b);
+
 void point_add(point *c, const point *g, const point *b, const bn_t p, const bn_t a);
 
 void point_dbl(point *c, const point *g, const bn_t p, const bn_t a);
@@ -1,36 +1,155 @@
 #include "SM2.h"
 #include "SM3.h"
+#include "batch.h"
 #include "bn.h"
 #include "ec.h"
+#include "ecp.h"
+#include "instr.h"
 #include "point.h"
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-void compute_z(uint8_t z[SM3_DIGEST_SIZE], group *g, const uint8_t *id, const size_t entl) {
-    SM3_CTX sm3_ctx;
-    SM3_Init(&sm3_ctx);
-    uint8_t entl_hex[2];
-    size_t len = entl * 8;
-    entl_hex[0] = (uint8_t)((len >> 8) & 0xFF);
-    entl_hex[1] = (uint8_t)(len & 0xFF);
-    // z = H(entl)
-    SM3_Update(&sm3_ctx, entl_hex, 2);
-    // z = H(entl || id)
-    SM3_Update(&sm3_ctx, id, entl);
-    // z = H(entl || id || a)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->a), strlen(bn_to_hex(g->a)));
-    // z = H(entl || id || a || b)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->b), strlen(bn_to_hex(g->b)));
-    // z = H(entl || id || a || b || xg)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->g.x), strlen(bn_to_hex(g->g.x)));
-    // z = H(entl || id || a || b || xg || yg)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->g.y), strlen(bn_to_hex(g->g.y)));
-    // z = H(entl || id || a || b || xg || yg || xa)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->g.x), strlen(bn_to_hex(g->g.x)));
-    // z = H(entl || id || a || b || xg || yg || xa || ya)
-    SM3_Update(&sm3_ctx, (uint8_t *)bn_to_hex(g->g.y), strlen(bn_to_hex(g->g.y)));
-    SM3_Final(&sm3_ctx, z);
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SM2_CPU_RELAX() _mm_pause()
+#else
+#include <sched.h>
+#define SM2_CPU_RELAX() sched_yield()
+#endif
+
+#define SM2_ZCACHE_SIZE   4096 /* Z缓存项数（直接映射） */
+#define SM2_ZCACHE_MAX_ID 64   /* 可缓存的最长用户标识（字节） */
+
+#define SM2_KEYGEN_CHUNK 128                               /* 批量生成密钥时共用一次求逆的密钥数 */
+#define SM2_SIGN_CHUNK   64                                /* 批量签名时共用一次求逆的签名数 */
+#define SM2_RAND_BYTES   (SM2_SCALAR_SIZE + RAND_DIST / 8) /* 每个随机标量取用的随机字节数 */
+
+/* Z缓存项，由各自的自旋锁保护 */
+typedef struct {
+    atomic_int lock;
+    int valid;
+    size_t entl;
+    uint8_t curve[SM3_DIGEST_SIZE]; /* 曲线参数a、b、G的摘要（group.tag） */
+    uint8_t id[SM2_ZCACHE_MAX_ID];
+    uint8_t pub[2 * SM2_SCALAR_SIZE];
+    uint8_t z[SM3_DIGEST_SIZE];
+} sm2_zcache_entry;
+
+static sm2_zcache_entry sm2_zcache[SM2_ZCACHE_SIZE];
+
+// 由公钥坐标的编码 xA || yA 计算Z
+static int sm2_compute_z_xy(uint8_t z[SM3_DIGEST_SIZE], const group *g, const uint8_t xy[2 * SM2_SCALAR_SIZE],
+                            const uint8_t *id, size_t entl) {
+    // ENTL || ID || a || b || xG || yG || xA || yA，一次性哈希
+    uint8_t buf[2 + SM2_MAX_ID_LEN + 6 * SM2_SCALAR_SIZE];
+    uint8_t *p;
+
+    if (entl > SM2_MAX_ID_LEN)
+        return SM2_INVALID_ID;
+
+    buf[0] = (uint8_t)((entl * 8) >> 8);
+    buf[1] = (uint8_t)(entl * 8);
+    if (entl > 0)
+        memcpy(buf + 2, id, entl);
+    p = buf + 2 + entl;
+    bn_to_bytes(p, SM2_SCALAR_SIZE, g->a);
+    bn_to_bytes(p + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, g->b);
+    bn_to_bytes(p + 2 * SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, g->g.x);
+    bn_to_bytes(p + 3 * SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, g->g.y);
+    memcpy(p + 4 * SM2_SCALAR_SIZE, xy, 2 * SM2_SCALAR_SIZE);
+
+    SM3(buf, 2 + entl + 6 * SM2_SCALAR_SIZE, z);
+    return SM2_SUCCESS;
+}
+
+int SM2_ComputeZ(uint8_t z[SM3_DIGEST_SIZE], const group *g, const point *pub, const uint8_t *id, size_t entl) {
+    uint8_t xy[2 * SM2_SCALAR_SIZE];
+
+    if (z == NULL || g == NULL || pub == NULL || (id == NULL && entl > 0))
+        return SM2_NULL_PTR;
+
+    bn_to_bytes(xy, SM2_SCALAR_SIZE, pub->x);
+    bn_to_bytes(xy + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, pub->y);
+    return sm2_compute_z_xy(z, g, xy, id, entl);
+}
+
+// 先只读等待锁释放再尝试获取，等待时让出流水线（x86上为pause，其他平台让出CPU）
+static void sm2_zcache_lock(sm2_zcache_entry *e) {
+    while (atomic_exchange_explicit(&e->lock, 1, memory_order_acquire))
+        while (atomic_load_explicit(&e->lock, memory_order_relaxed))
+            SM2_CPU_RELAX();
+}
+
+static void sm2_zcache_unlock(sm2_zcache_entry *e) {
+    atomic_store_explicit(&e->lock, 0, memory_order_release);
+}
+
+// 以(曲线, 用户标识, 公钥坐标的编码)为键查找Z缓存，未命中时计算并写入
+static int sm2_compute_z_cached_xy(uint8_t z[SM3_DIGEST_SIZE], const group *g, const uint8_t key[2 * SM2_SCALAR_SIZE],
+                                   const uint8_t *id, size_t entl) {
+    uint64_t h = 0xCBF29CE484222325ull; /* FNV-1a */
+    sm2_zcache_entry *e;
+    int ret, hit;
+
+    if (entl > SM2_ZCACHE_MAX_ID)
+        return sm2_compute_z_xy(z, g, key, id, entl);
+
+    for (size_t i = 0; i < SM3_DIGEST_SIZE; i++)
+        h = (h ^ g->tag[i]) * 0x100000001B3ull;
+    for (size_t i = 0; i < 2 * SM2_SCALAR_SIZE; i++)
+        h = (h ^ key[i]) * 0x100000001B3ull;
+    for (size_t i = 0; i < entl; i++)
+        h = (h ^ id[i]) * 0x100000001B3ull;
+    e = &sm2_zcache[(h ^ (h >> 32)) % SM2_ZCACHE_SIZE];
+
+    sm2_zcache_lock(e);
+    hit = e->valid && e->entl == entl && memcmp(e->pub, key, sizeof(e->pub)) == 0 &&
+          memcmp(e->curve, g->tag, sizeof(e->curve)) == 0 && (entl == 0 || memcmp(e->id, id, entl) == 0);
+    if (hit)
+        memcpy(z, e->z, SM3_DIGEST_SIZE);
+    sm2_zcache_unlock(e);
+    if (hit)
+        return SM2_SUCCESS;
+
+    ret = sm2_compute_z_xy(z, g, key, id, entl);
+    if (ret != SM2_SUCCESS)
+        return ret;
+
+    sm2_zcache_lock(e);
+    e->valid = 1;
+    e->entl = entl;
+    if (entl > 0)
+        memcpy(e->id, id, entl);
+    memcpy(e->pub, key, sizeof(e->pub));
+    memcpy(e->curve, g->tag, sizeof(e->curve));
+    memcpy(e->z, z, SM3_DIGEST_SIZE);
+    sm2_zcache_unlock(e);
+
+    return SM2_SUCCESS;
+}
+
+int SM2_ComputeZCached(uint8_t z[SM3_DIGEST_SIZE], const group *g, const point *pub, const uint8_t *id,
+                       size_t entl) {
+    uint8_t key[2 * SM2_SCALAR_SIZE];
+
+    if (z == NULL || g == NULL || pub == NULL || (id == NULL && entl > 0))
+        return SM2_NULL_PTR;
+
+    bn_to_bytes(key, SM2_SCALAR_SIZE, pub->x);
+    bn_to_bytes(key + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, pub->y);
+    return sm2_compute_z_cached_xy(z, g, key, id, entl);
+}
+
+void SM2_ZCacheClear(void) {
+    for (size_t i = 0; i < SM2_ZCACHE_SIZE; i++) {
+        sm2_zcache_lock(&sm2_zcache[i]);
+        sm2_zcache[i].valid = 0;
+        sm2_zcache_unlock(&sm2_zcache[i]);
+    }
 }
 
 void compute_e(uint8_t e[SM3_DIGEST_SIZE], const uint8_t z[SM3_DIGEST_SIZE], const uint8_t *msg, size_t mlen) {
@@ -41,85 +160,449 @@ void compute_e(uint8_t e[SM3_DIGEST_SIZE], const uint8_t z[SM3_DIGEST_SIZE], con
     SM3_Final(&sm3_ctx, e);
 }
 
+// 清除内存中的秘密数据（不会被编译器当作无用写入省略）
+static void sm2_wipe(void *buf, size_t len) {
+    volatile uint8_t *p = buf;
+
+    while (len--)
+        *p++ = 0;
+}
+
+// 私钥结构中公钥的校验值 SM3(曲线摘要 || d || xA || yA)，由构造私钥的函数写入
+static void sm2_pub_check(uint8_t chk[SM3_DIGEST_SIZE], const SM2_PRI_KEY *pri_key, const group *g) {
+    uint8_t buf[SM3_DIGEST_SIZE + 3 * SM2_SCALAR_SIZE];
+
+    memcpy(buf, g->tag, SM3_DIGEST_SIZE);
+    bn_to_bytes(buf + SM3_DIGEST_SIZE, SM2_SCALAR_SIZE, pri_key->d);
+    bn_to_bytes(buf + SM3_DIGEST_SIZE + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, pri_key->p.x);
+    bn_to_bytes(buf + SM3_DIGEST_SIZE + 2 * SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, pri_key->p.y);
+    SM3(buf, sizeof(buf), chk);
+    sm2_wipe(buf, sizeof(buf));
+}
+
 int SM2_GenerateKeyPair(SM2_PRI_KEY *pri_key, SM2_PUB_KEY *pub_key, group *g) {
     if (pri_key == NULL || pub_key == NULL || g == NULL)
         return SM2_NULL_PTR;
     create_group(g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
                  SM2_CURVE_PARAM_N);
     bn_rand_mod(pri_key->d, g->n);
-    point_mul(&pub_key->p, &g->g, pri_key->d, g->p, g->a);
+    // 私钥参与的标量乘均走常数时间路径
+    ecp_mul_point_ct(&pub_key->p, &g->g, pri_key->d, g);
+    point_new(&pri_key->p);
+    bn_copy(pri_key->p.x, pub_key->p.x);
+    bn_copy(pri_key->p.y, pub_key->p.y);
+    sm2_pub_check(pri_key->chk, pri_key, g);
     return SM2_SUCCESS;
 }
 
+/* 批量生成密钥的一个线程的任务：第first起的count个密钥 */
+typedef struct {
+    SM2_PRI_KEY *pri_keys;
+    SM2_PUB_KEY *pub_keys;
+    size_t first;
+    size_t count;
+    const uint8_t *rnd;  /* 全部私钥的随机字节 */
+    const ecp *table;    /* 基点的预计算表 */
+    const group *g;
+} sm2_keygen_job;
+
+// 检查私钥标量 1 <= d <= n - 2（1 + d可逆）
+static int sm2_check_scalar_key(const bn_t d, const group *g) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
+    int ret = SM2_SUCCESS;
+
+    bn_add_dig(t, d, 1);
+    if (d->sign == BN_NEG || bn_is_zero(d) || bn_cmp(t, g->n) != BN_LT)
+        ret = SM2_INVALID_KEY;
+
+    arena_release(ar, mark);
+    return ret;
+}
+
+// 由SM2_RAND_BYTES个随机字节得到[1, n - 2]内的标量（私钥要求1 + d可逆），越界时（概率约2^-255）重新取随机数
+static void sm2_rand_scalar(bn_t d, const uint8_t *rnd, const group *g) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
+
+    bn_from_bytes(d, rnd, SM2_RAND_BYTES);
+    bn_mod(d, d, g->n);
+    for (;;) {
+        bn_add_dig(t, d, 1);
+        if (!bn_is_zero(d) && bn_cmp(t, g->n) != BN_EQ)
+            break;
+        bn_rand_mod(d, g->n);
+    }
+    arena_release(ar, mark);
+}
+
+static void *sm2_keygen_worker(void *arg) {
+    sm2_keygen_job *job = arg;
+    const group *g = job->g;
+    const fp_ctx *f = &g->fp;
+    arena *ar = arena_thread();
+    size_t i, j, n, mark;
+    uint64_t *z, *zi;
+    ecp *r;
+    fp_t t, u, zz;
+
+    for (i = 0; i < job->count; i += n) {
+        n = job->count - i < SM2_KEYGEN_CHUNK ? job->count - i : SM2_KEYGEN_CHUNK;
+        mark = arena_mark(ar);
+        r = (ecp *)arena_alloc(ar, n * sizeof(ecp));
+        z = (uint64_t *)arena_alloc(ar, FP_DIGS * n * sizeof(uint64_t));
+        zi = (uint64_t *)arena_alloc(ar, FP_DIGS * n * sizeof(uint64_t));
+
+        // 私钥参与的标量乘走常数时间路径，结果留在Jacobian坐标
+        for (j = 0; j < n; j++) {
+            size_t k = job->first + i + j;
+            sm2_rand_scalar(job->pri_keys[k].d, job->rnd + k * SM2_RAND_BYTES, g);
+            ecp_mul_ct_tab(&r[j], job->table, job->pri_keys[k].d, g);
+            fp_vec_set(z, n, j, r[j].z);
+        }
+
+        // 整批的Z共用一次求逆，再逐个转为仿射点（d在[1, n - 2]内，结果不是无穷远点）
+        fp_vec_inv(zi, z, n, n, f, ar);
+        for (j = 0; j < n; j++) {
+            SM2_PRI_KEY *pri = &job->pri_keys[job->first + i + j];
+            SM2_PUB_KEY *pub = &job->pub_keys[job->first + i + j];
+
+            fp_vec_get(t, zi, n, j);
+            fp_sqr(zz, t, f);
+            fp_mul(u, r[j].x, zz, f);
+            fp_to_bn(pub->p.x, u, f);
+            fp_mul(zz, zz, t, f);
+            fp_mul(u, r[j].y, zz, f);
+            fp_to_bn(pub->p.y, u, f);
+            point_new(&pri->p);
+            bn_copy(pri->p.x, pub->p.x);
+            bn_copy(pri->p.y, pub->p.y);
+            sm2_pub_check(pri->chk, pri, g);
+        }
+        arena_release(ar, mark);
+    }
+    return NULL;
+}
+
+int SM2_GenerateKeyPairs(SM2_PRI_KEY *pri_keys, SM2_PUB_KEY *pub_keys, size_t count, group *g, int threads) {
+    if ((count > 0 && (pri_keys == NULL || pub_keys == NULL)) || g == NULL)
+        return SM2_NULL_PTR;
+    create_group(g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
+                 SM2_CURVE_PARAM_N);
+    if (count == 0)
+        return SM2_SUCCESS;
+
+    size_t chunks = (count + SM2_KEYGEN_CHUNK - 1) / SM2_KEYGEN_CHUNK, per;
+    ecp G, table[ECP_CT_TBL];
+    sm2_keygen_job *jobs;
+    pthread_t *tids;
+    uint8_t *rnd;
+    int t, started;
+
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)threads > chunks)
+        threads = (int)chunks;
+
+    rnd = malloc(count * SM2_RAND_BYTES);
+    jobs = malloc(threads * sizeof(sm2_keygen_job));
+    tids = malloc(threads * sizeof(pthread_t));
+    if (rnd == NULL || jobs == NULL || tids == NULL) {
+        free(rnd);
+        free(jobs);
+        free(tids);
+        return SM2_INTERNAL_ERROR;
+    }
+
+    // 全部私钥的随机数一次读取，基点的预计算表只算一次
+    bn_rand_bytes(rnd, count * SM2_RAND_BYTES);
+    ecp_set_point(&G, &g->g, g);
+    ecp_mul_ct_table(table, &G, g);
+
+    /* 按整批均分给各线程，第0段在调用线程中计算 */
+    per = (chunks + threads - 1) / threads * SM2_KEYGEN_CHUNK;
+    for (t = 0; t < threads; t++) {
+        jobs[t].pri_keys = pri_keys;
+        jobs[t].pub_keys = pub_keys;
+        jobs[t].first = t * per < count ? t * per : count;
+        jobs[t].count = jobs[t].first + per < count ? per : count - jobs[t].first;
+        jobs[t].rnd = rnd;
+        jobs[t].table = table;
+        jobs[t].g = g;
+    }
+
+    for (started = 1; started < threads; started++)
+        if (pthread_create(&tids[started], NULL, sm2_keygen_worker, &jobs[started]) != 0)
+            break;
+    // 线程创建失败时，未能启动的各段也在调用线程中计算，输出仍然完整
+    sm2_keygen_worker(&jobs[0]);
+    for (t = started; t < threads; t++)
+        sm2_keygen_worker(&jobs[t]);
+    for (t = 1; t < started; t++)
+        pthread_join(tids[t], NULL);
+
+    sm2_wipe(rnd, count * SM2_RAND_BYTES);
+    free(rnd);
+    free(jobs);
+    free(tids);
+    return SM2_SUCCESS;
+}
+
+/*
+ * 私钥结构中的公钥只在校验值匹配时（即由SM2_GenerateKeyPair(s)或SM2_DecodePriKey构造）直接使用；
+ * 否则（如调用方只设置了d）由d以常数时间标量乘计算到q，不写回私钥结构
+ */
+static const point *sm2_pri_key_pub(point *q, const SM2_PRI_KEY *pri_key, const group *g) {
+    uint8_t chk[SM3_DIGEST_SIZE];
+
+    sm2_pub_check(chk, pri_key, g);
+    if (memcmp(chk, pri_key->chk, SM3_DIGEST_SIZE) == 0)
+        return &pri_key->p;
+    point_new(q);
+    ecp_mul_point_ct(q, &g->g, pri_key->d, g);
+    return q;
+}
+
 int SM2_Sign(SM2_PRI_KEY *pri_key, group *g, const uint8_t *msg, size_t mlen, uint8_t *id, size_t entl, SM2_SIG *sig) {
     if (pri_key == NULL || g == NULL || sig == NULL)
         return SM2_NULL_PTR;
 
     // step 1: compute z
     uint8_t z[SM3_DIGEST_SIZE];
-    compute_z(z, g, id, entl);
+    point q;
+    int ret;
+    if (sm2_check_scalar_key(pri_key->d, g) != SM2_SUCCESS)
+        return SM2_INVALID_KEY;
+    INSTR_STAGE_BEGIN(INSTR_STAGE_Z);
+    ret = SM2_ComputeZCached(z, g, sm2_pri_key_pub(&q, pri_key, g), id, entl);
+    INSTR_STAGE_END(INSTR_STAGE_Z);
+    if (ret != SM2_SUCCESS)
+        return ret;
 
     // step 2: compute e
     uint8_t e_hex[SM3_DIGEST_SIZE];
+    INSTR_STAGE_BEGIN(INSTR_STAGE_E);
     compute_e(e_hex, z, msg, mlen);
-    bn_t e;
-    bn_new(e);
-    bn_from_digest(e, e_hex);
+    INSTR_STAGE_END(INSTR_STAGE_E);
 
-    bn_t k, r, s, t0, t1, t2, temp;
+    return SM2_SignDigest(pri_key, g, e_hex, sig);
+}
+
+/*
+ * 签名方程的step 3-6：e、d与(1 + d)^-1为模n的Montgomery形式，输出的r、s同为Montgomery形式，
+ * recid不为NULL时输出恢复标识
+ */
+static void sm2_sign_core(fp_t r, fp_t s, int *recid, const fp_t e, const fp_t d, const fp_t dinv, const group *g) {
+    // 临时变量取自线程内存区，不做清零，函数返回前整体释放
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *k = bn_tmp(ar);
+    const fp_ctx *fn = &g->fn;
+    fp_t fk, t;
     point Q;
     int retry;
 
     do {
         retry = 0;
-        bn_new(k);
-        bn_new(r);
-        bn_new(s);
-        bn_new(t0);
-        bn_new(t1);
-        bn_new(t2);
-        bn_new(temp);
 
         // step 3: generate k
         bn_rand_mod(k, g->n);
 
         // step 4: compute Q = kG
-        point_mul(&Q, &g->g, k, g->p, g->a);
+        INSTR_STAGE_BEGIN(INSTR_STAGE_MUL);
+        ecp_mul_point_ct(&Q, &g->g, k, g);
+        INSTR_STAGE_END(INSTR_STAGE_MUL);
 
+        INSTR_STAGE_BEGIN(INSTR_STAGE_FINAL);
         // step 5: compute r = (e + x1) mod n
-        bn_mod_add(r, Q.x, e, g->n);
+        fp_from_bn(t, Q.x, fn);
+        fp_add(r, e, t, fn);
 
-        // temp = r + k mod n
-        bn_mod_add(temp, r, k, g->n);
+        // t = r + k mod n
+        fp_from_bn(fk, k, fn);
+        fp_add(t, r, fk, fn);
 
         // if r = 0 or r + k = n, return to step 3
-        if (bn_is_zero(r) || bn_is_zero(temp)) {
+        if (fp_is_zero(r) || fp_is_zero(t)) {
+            INSTR_STAGE_END(INSTR_STAGE_FINAL);
             retry = 1;
             continue;
         }
 
-        // t0 = (1 + da)^-1 mod n
-        bn_add_dig(t0, pri_key->d, 1);
-        bn_mod_inv(t0, t0, g->n);
-        // t1 = r * da mod n
-        bn_mod_mul(t1, r, pri_key->d, g->n);
-        // t2 = (k - r * da) mod n
-        bn_mod_sub(t2, k, t1, g->n);
         // step 6: compute s = (k - r * da) * (1 + da)^-1 mod n
-        bn_mod_mul(s, t0, t2, g->n);
+        fp_mul(t, r, d, fn);
+        fp_sub(t, fk, t, fn);
+        fp_mul(s, t, dinv, fn);
+        INSTR_STAGE_END(INSTR_STAGE_FINAL);
 
         // if s = 0, return to step 3
-        if (bn_is_zero(s)) {
+        if (fp_is_zero(s)) {
             retry = 1;
             continue;
         }
 
     } while (retry);
 
+    // 恢复标识：第0位为y1的奇偶性，第1位表示x1 >= n
+    if (recid != NULL)
+        *recid = (int)(Q.y->dp[0] & 1) | (bn_cmp(Q.x, g->n) != BN_LT) << 1;
+
+    // 清除随机数k（取自线程内存区，否则留在其中）
+    sm2_wipe(k, sizeof(bn_st));
+    sm2_wipe(fk, sizeof(fk));
+    arena_release(ar, mark);
+}
+
+// recid不为NULL时输出恢复标识
+static int sm2_sign_digest(SM2_PRI_KEY *pri_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], SM2_SIG *sig,
+                           int *recid) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *h = bn_tmp(ar);
+    // 签名方程在阶n的定长上下文中以Montgomery形式计算
+    const fp_ctx *fn = &g->fn;
+    fp_t e, d, dinv, r, s;
+
+    // d = n - 1时1 + d不可逆，s恒为0，签名循环不会结束
+    if (sm2_check_scalar_key(pri_key->d, g) != SM2_SUCCESS) {
+        arena_release(ar, mark);
+        return SM2_INVALID_KEY;
+    }
+
+    // e可能不小于n，fp_from_bn同时完成模n约简
+    bn_from_digest(h, digest);
+    fp_from_bn(e, h, fn);
+
+    // (1 + da)^-1 mod n与k无关，在循环外计算
+    fp_from_bn(d, pri_key->d, fn);
+    fp_add(dinv, d, fn->one, fn);
+    fp_inv(dinv, dinv, fn);
+
+    sm2_sign_core(r, s, recid, e, d, dinv, g);
+
     // step 7: output (r, s)
-    bn_copy(sig->r, r);
-    bn_copy(sig->s, s);
+    fp_to_bn(sig->r, r, fn);
+    fp_to_bn(sig->s, s, fn);
 
+    sm2_wipe(d, sizeof(d));
+    sm2_wipe(dinv, sizeof(dinv));
+    arena_release(ar, mark);
+    return SM2_SUCCESS;
+}
+
+int SM2_SignDigest(SM2_PRI_KEY *pri_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], SM2_SIG *sig) {
+    if (pri_key == NULL || g == NULL || digest == NULL || sig == NULL)
+        return SM2_NULL_PTR;
+    return sm2_sign_digest(pri_key, g, digest, sig, NULL);
+}
+
+int SM2_SignDigestRecoverable(SM2_PRI_KEY *pri_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], SM2_SIG *sig,
+                              int *recid) {
+    if (pri_key == NULL || g == NULL || digest == NULL || sig == NULL || recid == NULL)
+        return SM2_NULL_PTR;
+    return sm2_sign_digest(pri_key, g, digest, sig, recid);
+}
+
+int SM2_SignBatch(SM2_PRI_KEY *pri_key, group *g, const uint8_t *const msgs[], const size_t mlens[], size_t count,
+                  uint8_t *id, size_t entl, SM2_SIG sigs[]) {
+    if (pri_key == NULL || g == NULL || (count > 0 && (msgs == NULL || mlens == NULL || sigs == NULL)))
+        return SM2_NULL_PTR;
+
+    const fp_ctx *fn = &g->fn, *fp = &g->fp;
+    const SM3_CTX *pre[SM2_SIGN_CHUNK];
+    uint8_t z[SM3_DIGEST_SIZE], e[SM2_SIGN_CHUNK][SM3_DIGEST_SIZE], rnd[SM2_SIGN_CHUNK * SM2_RAND_BYTES];
+    SM3_CTX zctx;
+    ecp G, table[ECP_CT_TBL];
+    point q;
+    fp_t d, dinv, r, s, t, u;
+    arena *ar = arena_thread();
+    size_t i, j, n, mark;
+    int ret;
+
+    // 消息指针在签名前全部检查，避免部分签名已输出后才失败
+    for (i = 0; i < count; i++)
+        if (msgs[i] == NULL && mlens[i] > 0)
+            return SM2_NULL_PTR;
+
+    // d = n - 1时1 + d不可逆，s恒为0
+    if (sm2_check_scalar_key(pri_key->d, g) != SM2_SUCCESS)
+        return SM2_INVALID_KEY;
+
+    // Z与(1 + da)^-1对整批只计算一次
+    ret = SM2_ComputeZCached(z, g, sm2_pri_key_pub(&q, pri_key, g), id, entl);
+    if (ret != SM2_SUCCESS)
+        return ret;
+    SM3_Init(&zctx);
+    SM3_Update(&zctx, z, SM3_DIGEST_SIZE);
+    for (j = 0; j < SM2_SIGN_CHUNK; j++)
+        pre[j] = &zctx;
+
+    fp_from_bn(d, pri_key->d, fn);
+    fp_add(dinv, d, fn->one, fn);
+    fp_inv(dinv, dinv, fn);
+
+    ecp_set_point(&G, &g->g, g);
+    ecp_mul_ct_table(table, &G, g);
+
+    for (i = 0; i < count; i += n) {
+        n = count - i < SM2_SIGN_CHUNK ? count - i : SM2_SIGN_CHUNK;
+        mark = arena_mark(ar);
+        bn_st *h = bn_tmp(ar);
+        fp_t *fk = (fp_t *)arena_alloc(ar, n * sizeof(fp_t));
+        ecp *q = (ecp *)arena_alloc(ar, n * sizeof(ecp));
+        uint64_t *qz = (uint64_t *)arena_alloc(ar, FP_DIGS * n * sizeof(uint64_t));
+        uint64_t *qzi = (uint64_t *)arena_alloc(ar, FP_DIGS * n * sizeof(uint64_t));
+
+        // e_i = H(Z || M_i)，各消息从同一个已吸收Z的上下文出发，在多缓冲区SM3的通道中并行哈希
+        if (SM3_MultiBufferFinal(pre, msgs + i, mlens + i, n, e) != SM3_SUCCESS) {
+            arena_release(ar, mark);
+            return SM2_NULL_PTR;
+        }
+
+        // Q_i = k_i G留在Jacobian坐标，整批的Z共用一次求逆后只取x1
+        bn_rand_bytes(rnd, n * SM2_RAND_BYTES);
+        for (j = 0; j < n; j++) {
+            sm2_rand_scalar(h, rnd + j * SM2_RAND_BYTES, g);
+            fp_from_bn(fk[j], h, fn);
+            ecp_mul_ct_tab(&q[j], table, h, g);
+            fp_vec_set(qz, n, j, q[j].z);
+        }
+        bn_zero(h);
+        sm2_wipe(rnd, sizeof(rnd));
+        fp_vec_inv(qzi, qz, n, n, fp, ar);
+
+        for (j = 0; j < n; j++) {
+            // x1 = X / Z^2，再进入模n的上下文（fp_from_bn同时约简不小于n的x1与e）
+            fp_vec_get(t, qzi, n, j);
+            fp_sqr(t, t, fp);
+            fp_mul(t, q[j].x, t, fp);
+            fp_to_bn(h, t, fp);
+            fp_from_bn(u, h, fn);
+            bn_from_digest(h, e[j]);
+            fp_from_bn(t, h, fn);
+
+            // r = (e + x1) mod n，s = (k - r * da) * (1 + da)^-1 mod n
+            fp_add(r, t, u, fn);
+            fp_add(t, r, fk[j], fn);
+            fp_mul(u, r, d, fn);
+            fp_sub(u, fk[j], u, fn);
+            fp_mul(s, u, dinv, fn);
+
+            // r = 0、r + k = n或s = 0时（概率可忽略）对这条消息按单条签名重新选k
+            if (fp_is_zero(r) || fp_is_zero(t) || fp_is_zero(s)) {
+                sm2_sign_digest(pri_key, g, e[j], &sigs[i + j], NULL);
+                continue;
+            }
+            fp_to_bn(sigs[i + j].r, r, fn);
+            fp_to_bn(sigs[i + j].s, s, fn);
+        }
+        sm2_wipe(fk, n * sizeof(fp_t));
+        arena_release(ar, mark);
+    }
+    sm2_wipe(d, sizeof(d));
+    sm2_wipe(dinv, sizeof(dinv));
     return SM2_SUCCESS;
 }
 
@@ -128,18 +611,34 @@ int SM2_Verify(SM2_PUB_KEY *pub_key, group *g, const uint8_t *msg, size_t mlen,
     if (pub_key == NULL || g == NULL || sig == NULL)
         return SM2_NULL_PTR;
 
-    bn_t r, s, t, R;
-    bn_new(r);
-    bn_new(s);
-    bn_new(t);
-    bn_new(R);
+    // step 3: compute z
+    uint8_t z[SM3_DIGEST_SIZE];
+    int ret;
+    INSTR_STAGE_BEGIN(INSTR_STAGE_Z);
+    ret = SM2_ComputeZCached(z, g, &pub_key->p, id, entl);
+    INSTR_STAGE_END(INSTR_STAGE_Z);
+    if (ret != SM2_SUCCESS)
+        return ret;
+
+    // step 4: compute e
+    uint8_t e_hex[SM3_DIGEST_SIZE];
+    INSTR_STAGE_BEGIN(INSTR_STAGE_E);
+    compute_e(e_hex, z, msg, mlen);
+    INSTR_STAGE_END(INSTR_STAGE_E);
 
-    point P, Q;
-    point_new(&P);
-    point_new(&Q);
+    return SM2_VerifyDigest(pub_key, g, e_hex, sig);
+}
 
-    bn_copy(r, sig->r);
-    bn_copy(s, sig->s);
+// 验签的step 1-2与5-7：公钥为Jacobian点P，P在计算中被改写
+static int sm2_verify_core(ecp *P, const group *g, const uint8_t digest[SM3_DIGEST_SIZE], const bn_t r,
+                           const bn_t s) {
+    const fp_ctx *fn = &g->fn;
+    arena *ar;
+    size_t mark;
+    bn_st *t, *e, *x;
+    fp_t fr, ft, fe, fx;
+    ecp G;
+    int ret = SM2_INVALID_SIG;
 
     // step 1: check r
     if (bn_cmp_dig(r, 1) == BN_LT || bn_cmp(r, g->n) != BN_LT)
@@ -149,31 +648,363 @@ int SM2_Verify(SM2_PUB_KEY *pub_key, group *g, const uint8_t *msg, size_t mlen,
     if (bn_cmp_dig(s, 1) == BN_LT || bn_cmp(s, g->n) != BN_LT)
         return SM2_INVALID_SIG;
 
-    // step 3: compute z
-    uint8_t z[SM3_DIGEST_SIZE];
-    compute_z(z, g, id, entl);
+    // 临时变量取自线程内存区，不做清零，函数返回前整体释放
+    ar = arena_thread();
+    mark = arena_mark(ar);
+    t = bn_tmp(ar);
+    e = bn_tmp(ar);
+    x = bn_tmp(ar);
 
-    // step 4: compute e
-    uint8_t e_hex[SM3_DIGEST_SIZE];
-    compute_e(e_hex, z, msg, mlen);
-    bn_t e;
-    bn_new(e);
-    bn_from_digest(e, e_hex);
+    // step 3-4: e = H(Z || M) is computed by the caller
+    bn_from_digest(e, digest);
 
     // step 5: compute t = (r + s) mod n
-    bn_mod_add(t, r, s, g->n);
-    if (bn_is_zero(t))
-        return SM2_INVALID_SIG;
+    fp_from_bn(fr, r, fn);
+    fp_from_bn(ft, s, fn);
+    fp_add(ft, fr, ft, fn);
+    if (fp_is_zero(ft))
+        goto end;
+    fp_to_bn(t, ft, fn);
+
+    // step 6: compute Q = sG + tPa，s、t与公钥均公开，用交错的wNAF
+    INSTR_STAGE_BEGIN(INSTR_STAGE_MUL);
+    ecp_set_point(&G, &g->g, g);
+    ecp_mul2_vartime(P, &G, s, P, t, g);
+    INSTR_STAGE_END(INSTR_STAGE_MUL);
+
+    /*
+     * step 7: R = e + x1 mod n == r等价于x1 ≡ r - e (mod n)。x1在[0, p)内而2n > p，
+     * 故x1只可能是x1' = (r - e) mod n或x1' + n（仅当x1' + n < p），直接与Jacobian坐标的X比较，不求逆
+     */
+    INSTR_STAGE_BEGIN(INSTR_STAGE_FINAL);
+    fp_from_bn(fe, e, fn);
+    fp_sub(fx, fr, fe, fn);
+    fp_to_bn(x, fx, fn);
+    if (ecp_x_equals(P, x, g)) {
+        ret = SM2_SUCCESS;
+    } else {
+        bn_add(x, x, g->n);
+        if (bn_cmp(x, g->p) == BN_LT && ecp_x_equals(P, x, g))
+            ret = SM2_SUCCESS;
+    }
+    INSTR_STAGE_END(INSTR_STAGE_FINAL);
+
+end:
+    arena_release(ar, mark);
+    return ret;
+}
+
+int SM2_VerifyDigest(SM2_PUB_KEY *pub_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], const SM2_SIG *sig) {
+    if (pub_key == NULL || g == NULL || digest == NULL || sig == NULL)
+        return SM2_NULL_PTR;
 
-    // step 6: compute Q = sG + tPa
-    point_mul(&Q, &g->g, s, g->p, g->a);
-    point_mul(&P, &pub_key->p, t, g->p, g->a);
-    point_add(&Q, &Q, &P, g->p, g->a);
+    ecp P;
 
-    // step 7: compute R = e + x1 mod n
-    bn_mod_add(R, e, Q.x, g->n);
-    if (bn_cmp(R, r) != BN_EQ)
+    ecp_set_point(&P, &pub_key->p, g);
+    return sm2_verify_core(&P, g, digest, sig->r, sig->s);
+}
+
+int SM2_RecoverPublicKey(SM2_PUB_KEY *pub_key, group *g, const uint8_t digest[SM3_DIGEST_SIZE], const SM2_SIG *sig,
+                         int recid) {
+    if (pub_key == NULL || g == NULL || digest == NULL || sig == NULL)
+        return SM2_NULL_PTR;
+
+    const bn_st *r = sig->r, *s = sig->s;
+    const fp_ctx *fn = &g->fn;
+    const fp_t zero = {0};
+    arena *ar;
+    size_t mark;
+    bn_st *u, *v, *x;
+    fp_t fr, fs, ft, fe;
+    ecp G, R;
+    int ret = SM2_INVALID_SIG;
+
+    // 与验签相同的范围检查
+    if (recid < 0 || recid > 3)
+        return SM2_INVALID_SIG;
+    if (bn_cmp_dig(r, 1) == BN_LT || bn_cmp(r, g->n) != BN_LT)
         return SM2_INVALID_SIG;
+    if (bn_cmp_dig(s, 1) == BN_LT || bn_cmp(s, g->n) != BN_LT)
+        return SM2_INVALID_SIG;
+
+    ar = arena_thread();
+    mark = arena_mark(ar);
+    u = bn_tmp(ar);
+    v = bn_tmp(ar);
+    x = bn_tmp(ar);
+
+    // t = (r + s) mod n
+    fp_from_bn(fr, r, fn);
+    fp_from_bn(fs, s, fn);
+    fp_add(ft, fr, fs, fn);
+    if (fp_is_zero(ft))
+        goto end;
+
+    // x1 = (r - e) mod n，recid第1位为1时x1 + n，由x1与y1的奇偶性恢复R
+    bn_from_digest(x, digest);
+    fp_from_bn(fe, x, fn);
+    fp_sub(fe, fr, fe, fn);
+    fp_to_bn(x, fe, fn);
+    if (recid & 2)
+        bn_add(x, x, g->n);
+    if (!ecp_set_x(&R, x, recid & 1, g))
+        goto end;
+
+    // sG + tP = R，故P = t^-1 R - t^-1 s G，两个标量均公开
+    fp_inv(ft, ft, fn);
+    fp_to_bn(u, ft, fn);
+    fp_mul(fs, fs, ft, fn);
+    fp_sub(fs, zero, fs, fn);
+    fp_to_bn(v, fs, fn);
+    ecp_set_point(&G, &g->g, g);
+    ecp_mul2_vartime(&R, &R, u, &G, v, g);
+    if (ecp_is_infty(&R))
+        goto end;
+    ecp_get_point(&pub_key->p, &R, g);
+    ret = SM2_SUCCESS;
+
+end:
+    arena_release(ar, mark);
+    return ret;
+}
+
+int SM2_EncodePriKey(uint8_t out[SM2_SCALAR_SIZE], const SM2_PRI_KEY *pri_key) {
+    if (out == NULL || pri_key == NULL)
+        return SM2_NULL_PTR;
+    bn_to_bytes(out, SM2_SCALAR_SIZE, pri_key->d);
+    return SM2_SUCCESS;
+}
+
+// 解码私钥标量并检查 1 <= d <= n - 2
+static int sm2_decode_scalar_key(bn_t d, const group *g, const uint8_t in[SM2_SCALAR_SIZE]) {
+    bn_from_bytes(d, in, SM2_SCALAR_SIZE);
+    return sm2_check_scalar_key(d, g);
+}
+
+int SM2_DecodePriKey(SM2_PRI_KEY *pri_key, const group *g, const uint8_t in[SM2_SCALAR_SIZE]) {
+    if (pri_key == NULL || g == NULL || in == NULL)
+        return SM2_NULL_PTR;
+
+    if (sm2_decode_scalar_key(pri_key->d, g, in) != SM2_SUCCESS)
+        return SM2_INVALID_KEY;
+    ecp_mul_point_ct(&pri_key->p, &g->g, pri_key->d, g);
+    sm2_pub_check(pri_key->chk, pri_key, g);
+
+    return SM2_SUCCESS;
+}
+
+int SM2_EncodePubKey(uint8_t out[SM2_PUB_SIZE], const SM2_PUB_KEY *pub_key) {
+    if (out == NULL || pub_key == NULL)
+        return SM2_NULL_PTR;
+    out[0] = 0x04;
+    bn_to_bytes(out + 1, SM2_SCALAR_SIZE, pub_key->p.x);
+    bn_to_bytes(out + 1 + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, pub_key->p.y);
+    return SM2_SUCCESS;
+}
+
+int SM2_EncodePubKeyCompressed(uint8_t out[SM2_PUB_COMPRESSED_SIZE], const SM2_PUB_KEY *pub_key) {
+    if (out == NULL || pub_key == NULL)
+        return SM2_NULL_PTR;
+    out[0] = 0x02 | (pub_key->p.y->dp[0] & 1);
+    bn_to_bytes(out + 1, SM2_SCALAR_SIZE, pub_key->p.x);
+    return SM2_SUCCESS;
+}
+
+int SM2_DecodePubKey(SM2_PUB_KEY *pub_key, const group *g, const uint8_t *in, size_t len) {
+    if (pub_key == NULL || g == NULL || in == NULL)
+        return SM2_NULL_PTR;
+
+    // 压缩形式：由x与y的奇偶性恢复y
+    if (len == SM2_PUB_COMPRESSED_SIZE && (in[0] == 0x02 || in[0] == 0x03)) {
+        bn_t x;
+        bn_from_bytes(x, in + 1, SM2_SCALAR_SIZE);
+        if (!point_decompress(&pub_key->p, x, in[0] & 1, g->p, g->a, g->b))
+            return SM2_INVALID_KEY;
+        return SM2_SUCCESS;
+    }
+
+    if (len != SM2_PUB_SIZE || in[0] != 0x04)
+        return SM2_INVALID_KEY;
+
+    bn_from_bytes(pub_key->p.x, in + 1, SM2_SCALAR_SIZE);
+    bn_from_bytes(pub_key->p.y, in + 1 + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE);
+    if (!point_on_curve(&pub_key->p, g->p, g->a, g->b))
+        return SM2_INVALID_KEY;
 
     return SM2_SUCCESS;
 }
+
+int SM2_EncodeSig(uint8_t out[SM2_SIG_SIZE], const SM2_SIG *sig) {
+    if (out == NULL || sig == NULL)
+        return SM2_NULL_PTR;
+    bn_to_bytes(out, SM2_SCALAR_SIZE, sig->r);
+    bn_to_bytes(out + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, sig->s);
+    return SM2_SUCCESS;
+}
+
+int SM2_DecodeSig(SM2_SIG *sig, const uint8_t in[SM2_SIG_SIZE]) {
+    if (sig == NULL || in == NULL)
+        return SM2_NULL_PTR;
+    bn_from_bytes(sig->r, in, SM2_SCALAR_SIZE);
+    bn_from_bytes(sig->s, in + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE);
+    return SM2_SUCCESS;
+}
+
+/*
+ * 解码公钥为Jacobian点（Z = 1），在域p的定长上下文中检查y^2 = x^3 + ax + b，
+ * 同时输出未压缩的坐标编码 xA || yA（计算Z时使用）
+ */
+static int sm2_decode_pub_ecp(ecp *P, uint8_t xy[2 * SM2_SCALAR_SIZE], const group *g, const uint8_t *in,
+                              size_t len) {
+    const fp_ctx *f = &g->fp;
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *x = bn_tmp(ar), *y = bn_tmp(ar);
+    fp_t l, r, t;
+    int ret = SM2_INVALID_KEY;
+
+    // 压缩形式：由x与y的奇偶性恢复y
+    if (len == SM2_PUB_COMPRESSED_SIZE && (in[0] == 0x02 || in[0] == 0x03)) {
+        bn_from_bytes(x, in + 1, SM2_SCALAR_SIZE);
+        if (!ecp_set_x(P, x, in[0] & 1, g))
+            goto end;
+        fp_to_bn(y, P->y, f);
+        memcpy(xy, in + 1, SM2_SCALAR_SIZE);
+        bn_to_bytes(xy + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, y);
+        ret = SM2_SUCCESS;
+        goto end;
+    }
+
+    if (len != SM2_PUB_SIZE || in[0] != 0x04)
+        goto end;
+    bn_from_bytes(x, in + 1, SM2_SCALAR_SIZE);
+    bn_from_bytes(y, in + 1 + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE);
+    if (bn_cmp(x, g->p) != BN_LT || bn_cmp(y, g->p) != BN_LT)
+        goto end;
+    fp_from_bn(P->x, x, f);
+    fp_from_bn(P->y, y, f);
+    fp_copy(P->z, f->one);
+
+    // y^2 = (x^2 + a)x + b
+    fp_sqr(l, P->y, f);
+    fp_sqr(r, P->x, f);
+    fp_add(r, r, g->ma, f);
+    fp_mul(r, r, P->x, f);
+    fp_from_bn(t, g->b, f);
+    fp_add(r, r, t, f);
+    if (!fp_equal(l, r))
+        goto end;
+    memcpy(xy, in + 1, 2 * SM2_SCALAR_SIZE);
+    ret = SM2_SUCCESS;
+
+end:
+    arena_release(ar, mark);
+    return ret;
+}
+
+// 不求逆地判断Jacobian点a是否等于Z = 1的点b：比较X与xZ^2、Y与yZ^3
+static int sm2_ecp_equal_affine(const ecp *a, const ecp *b, const group *g) {
+    const fp_ctx *f = &g->fp;
+    fp_t zz, t;
+    int eq;
+
+    fp_sqr(zz, a->z, f);
+    fp_mul(t, b->x, zz, f);
+    eq = fp_equal(t, a->x);
+    fp_mul(zz, zz, a->z, f);
+    fp_mul(t, b->y, zz, f);
+    return eq & fp_equal(t, a->y) & !ecp_is_infty(a);
+}
+
+int SM2_SignPacked(const uint8_t pri[SM2_SCALAR_SIZE], const uint8_t *pub, size_t publen, group *g,
+                   const uint8_t *msg, size_t mlen, uint8_t *id, size_t entl, uint8_t sig[SM2_SIG_SIZE]) {
+    if (pri == NULL || pub == NULL || g == NULL || sig == NULL)
+        return SM2_NULL_PTR;
+
+    const fp_ctx *fn = &g->fn;
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *k = bn_tmp(ar), *h = bn_tmp(ar);
+    uint8_t xy[2 * SM2_SCALAR_SIZE], z[SM3_DIGEST_SIZE], e_hex[SM3_DIGEST_SIZE];
+    fp_t e, d, dinv, r, s;
+    ecp P, D;
+    int ret;
+
+    // 私钥与签名方程只在阶n的定长上下文中运算，不构造SM2_PRI_KEY/SM2_PUB_KEY/SM2_SIG
+    bn_from_bytes(k, pri, SM2_SCALAR_SIZE);
+    ret = sm2_check_scalar_key(k, g);
+    if (ret == SM2_SUCCESS)
+        ret = sm2_decode_pub_ecp(&P, xy, g, pub, publen);
+
+    // Z由公钥计算，公钥与私钥不匹配时签名无法验证：以一次常数时间标量乘检查公钥等于dG
+    if (ret == SM2_SUCCESS) {
+        ecp_set_point(&D, &g->g, g);
+        ecp_mul_ct(&D, &D, k, g);
+        if (!sm2_ecp_equal_affine(&D, &P, g))
+            ret = SM2_INVALID_KEY;
+    }
+
+    if (ret == SM2_SUCCESS) {
+        INSTR_STAGE_BEGIN(INSTR_STAGE_Z);
+        ret = sm2_compute_z_cached_xy(z, g, xy, id, entl);
+        INSTR_STAGE_END(INSTR_STAGE_Z);
+    }
+
+    if (ret == SM2_SUCCESS) {
+        INSTR_STAGE_BEGIN(INSTR_STAGE_E);
+        compute_e(e_hex, z, msg, mlen);
+        INSTR_STAGE_END(INSTR_STAGE_E);
+
+        bn_from_digest(h, e_hex);
+        fp_from_bn(e, h, fn);
+        fp_from_bn(d, k, fn);
+        fp_add(dinv, d, fn->one, fn);
+        fp_inv(dinv, dinv, fn);
+        sm2_sign_core(r, s, NULL, e, d, dinv, g);
+
+        fp_to_bn(h, r, fn);
+        bn_to_bytes(sig, SM2_SCALAR_SIZE, h);
+        fp_to_bn(h, s, fn);
+        bn_to_bytes(sig + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, h);
+    }
+
+    // 清除私钥及其Montgomery形式
+    sm2_wipe(k, sizeof(bn_st));
+    sm2_wipe(d, sizeof(d));
+    sm2_wipe(dinv, sizeof(dinv));
+    arena_release(ar, mark);
+    return ret;
+}
+
+int SM2_VerifyPacked(const uint8_t *pub, size_t publen, group *g, const uint8_t *msg, size_t mlen, uint8_t *id,
+                     size_t entl, const uint8_t sig[SM2_SIG_SIZE]) {
+    if (pub == NULL || g == NULL || sig == NULL)
+        return SM2_NULL_PTR;
+
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *r = bn_tmp(ar), *s = bn_tmp(ar);
+    uint8_t xy[2 * SM2_SCALAR_SIZE], z[SM3_DIGEST_SIZE], e_hex[SM3_DIGEST_SIZE];
+    ecp P;
+    int ret;
+
+    ret = sm2_decode_pub_ecp(&P, xy, g, pub, publen);
+    if (ret == SM2_SUCCESS) {
+        INSTR_STAGE_BEGIN(INSTR_STAGE_Z);
+        ret = sm2_compute_z_cached_xy(z, g, xy, id, entl);
+        INSTR_STAGE_END(INSTR_STAGE_Z);
+    }
+
+    if (ret == SM2_SUCCESS) {
+        INSTR_STAGE_BEGIN(INSTR_STAGE_E);
+        compute_e(e_hex, z, msg, mlen);
+        INSTR_STAGE_END(INSTR_STAGE_E);
+
+        bn_from_bytes(r, sig, SM2_SCALAR_SIZE);
+        bn_from_bytes(s, sig + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE);
+        ret = sm2_verify_core(&P, g, e_hex, r, s);
+    }
+
+    arena_release(ar, mark);
+    return ret;
+}
@@ -1,4 +1,5 @@
 #include "SM3.h"
+#include "instr.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -7,28 +8,66 @@
 
 /* 布尔函数定义 */
 #define FF0(x, y, z) ((x) ^ (y) ^ (z))
-#define FF1(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
+#define FF1(x, y, z) (((x) & (y)) | (((x) | (y)) & (z)))
 #define GG0(x, y, z) ((x) ^ (y) ^ (z))
-#define GG1(x, y, z) (((x) & (y)) | ((~x) & (z)))
+#define GG1(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
 
 /* 置换函数定义 */
 #define P0(x) ((x) ^ ROTL(x, 9) ^ ROTL(x, 17))
 #define P1(x) ((x) ^ ROTL(x, 15) ^ ROTL(x, 23))
 
+/* 大端读取32位字 */
+#define LOAD32_BE(p)                                                                                                   \
+    ((uint32_t)(p)[0] << 24 | (uint32_t)(p)[1] << 16 | (uint32_t)(p)[2] << 8 | (uint32_t)(p)[3])
+
+/* 消息扩展：W只保留16个字，第k轮前就地生成W[k+4] */
+#define EXPAND(k)                                                                                                      \
+    W[((k) + 4) & 15] = P1(W[((k) + 4) & 15] ^ W[((k) + 11) & 15] ^ ROTL(W[((k) + 1) & 15], 15)) ^                    \
+                        ROTL(W[((k) + 7) & 15], 7) ^ W[((k) + 14) & 15]
+
+#define NO_EXPAND(k)
+
+/*
+ * 单轮压缩：通过轮换变量名代替寄存器间的移动，
+ * TT1写入D的位置，P0(TT2)写入H的位置，下一轮以(D, A, B, C, H, E, F, G)调用
+ */
+#define ROUND(A, B, C, D, E, F, G, H, FF, GG, t, k)                                                                    \
+    do {                                                                                                               \
+        uint32_t a12 = ROTL(A, 12);                                                                                    \
+        uint32_t ss1 = ROTL(a12 + E + SM3_TJ[t], 7);                                                                   \
+        uint32_t ss2 = ss1 ^ a12;                                                                                      \
+        D = FF(A, B, C) + D + ss2 + (W[(k) & 15] ^ W[((k) + 4) & 15]);                                                 \
+        H = GG(E, F, G) + H + ss1 + W[(k) & 15];                                                                       \
+        B = ROTL(B, 9);                                                                                                \
+        F = ROTL(F, 19);                                                                                               \
+        H = P0(H);                                                                                                     \
+    } while (0)
+
+/* 四轮展开，四轮后变量名回到原位 */
+#define ROUNDS4(FF, GG, XP, t, k)                                                                                      \
+    XP(k);                                                                                                             \
+    ROUND(A, B, C, D, E, F, G, H, FF, GG, (t), (k));                                                                   \
+    XP((k) + 1);                                                                                                       \
+    ROUND(D, A, B, C, H, E, F, G, FF, GG, (t) + 1, (k) + 1);                                                           \
+    XP((k) + 2);                                                                                                       \
+    ROUND(C, D, A, B, G, H, E, F, FF, GG, (t) + 2, (k) + 2);                                                           \
+    XP((k) + 3);                                                                                                       \
+    ROUND(B, C, D, A, F, G, H, E, FF, GG, (t) + 3, (k) + 3)
+
 /* SM3初始哈希值 */
 static const uint32_t SM3_INITIAL_STATE[SM3_STATE_WORDS] = {0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
                                                             0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e};
 
-/* SM3常量表 */
+/* SM3常量表：预先循环移位的轮常量 ROTL(T_j, j mod 32) */
 static const uint32_t SM3_TJ[64] = {
-    0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519,
-    0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519, 0x79cc4519,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a,
-    0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a, 0x7a879d8a};
+    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb, 0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
+    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce, 0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5,
+    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
+    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5};
 
 int SM3_Init(SM3_CTX *ctx) {
     /* 检查输入参数 */
@@ -88,11 +127,12 @@ int SM3_Update(SM3_CTX *ctx, const uint8_t *data, size_t len) {
         }
     }
 
-    /* 处理完整的数据块（64字节） */
-    while (len >= SM3_BLOCK_SIZE) {
-        SM3_Compress(ctx->state, data);
-        data += SM3_BLOCK_SIZE;
-        len -= SM3_BLOCK_SIZE;
+    /* 连续的完整数据块（64字节）直接从输入压缩，不经过缓冲区 */
+    if (len >= SM3_BLOCK_SIZE) {
+        size_t nblocks = len / SM3_BLOCK_SIZE;
+        SM3_CompressBlocks(ctx->state, data, nblocks);
+        data += nblocks * SM3_BLOCK_SIZE;
+        len -= nblocks * SM3_BLOCK_SIZE;
     }
 
     /* 将剩余数据复制到缓冲区 */
@@ -148,6 +188,175 @@ int SM3(const uint8_t *data, size_t len, uint8_t digest[SM3_DIGEST_SIZE]) {
     return SM3_SUCCESS;
 }
 
+int SM3_Copy(SM3_CTX *dst, const SM3_CTX *src) {
+    /* 检查输入参数 */
+    if (dst == NULL || src == NULL)
+        return SM3_NULL_PTR;
+
+    /* 缓冲区只复制有效部分 */
+    memcpy(dst->state, src->state, sizeof(src->state));
+    dst->total_len = src->total_len;
+    memcpy(dst->block, src->block, src->block_len);
+    dst->block_len = src->block_len;
+
+    return SM3_SUCCESS;
+}
+
+int SM3_Export(const SM3_CTX *ctx, uint8_t out[SM3_EXPORT_SIZE]) {
+    /* 检查输入参数 */
+    if (ctx == NULL || out == NULL)
+        return SM3_NULL_PTR;
+
+    for (int i = 0; i < SM3_STATE_WORDS; i++) {
+        out[i * 4] = (ctx->state[i] >> 24) & 0xFF;
+        out[i * 4 + 1] = (ctx->state[i] >> 16) & 0xFF;
+        out[i * 4 + 2] = (ctx->state[i] >> 8) & 0xFF;
+        out[i * 4 + 3] = ctx->state[i] & 0xFF;
+    }
+    out += SM3_STATE_WORDS * 4;
+
+    for (int i = 0; i < 8; i++)
+        out[i] = (ctx->total_len >> (56 - i * 8)) & 0xFF;
+    out += 8;
+
+    /* 缓冲区无效部分补0，保证相同状态的导出结果相同 */
+    out[0] = (uint8_t)ctx->block_len;
+    memcpy(out + 1, ctx->block, ctx->block_len);
+    memset(out + 1 + ctx->block_len, 0, SM3_BLOCK_SIZE - ctx->block_len);
+
+    return SM3_SUCCESS;
+}
+
+int SM3_Import(SM3_CTX *ctx, const uint8_t in[SM3_EXPORT_SIZE]) {
+    uint64_t total_len = 0;
+    size_t block_len;
+
+    /* 检查输入参数 */
+    if (ctx == NULL || in == NULL)
+        return SM3_NULL_PTR;
+
+    for (int i = 0; i < 8; i++)
+        total_len = (total_len << 8) | in[SM3_STATE_WORDS * 4 + i];
+    block_len = in[SM3_STATE_WORDS * 4 + 8];
+
+    /* 缓冲长度必须与总长度一致 */
+    if (block_len >= SM3_BLOCK_SIZE || total_len % SM3_BLOCK_SIZE != block_len)
+        return SM3_INVALID_LENGTH;
+
+    for (int i = 0; i < SM3_STATE_WORDS; i++)
+        ctx->state[i] = LOAD32_BE(in + i * 4);
+    ctx->total_len = total_len;
+    ctx->block_len = block_len;
+    memcpy(ctx->block, in + SM3_STATE_WORDS * 4 + 9, block_len);
+
+    return SM3_SUCCESS;
+}
+
+int SM3_HMAC_SetKey(SM3_HMAC_KEY *hkey, const uint8_t *key, size_t klen) {
+    uint8_t k[SM3_BLOCK_SIZE], pad[SM3_BLOCK_SIZE];
+
+    /* 检查输入参数 */
+    if (hkey == NULL || (key == NULL && klen > 0))
+        return SM3_NULL_PTR;
+
+    /* 长密钥先哈希，短密钥补0到分组长度 */
+    memset(k, 0, sizeof(k));
+    if (klen > SM3_BLOCK_SIZE)
+        SM3(key, klen, k);
+    else if (klen > 0)
+        memcpy(k, key, klen);
+
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+        pad[i] = k[i] ^ 0x36;
+    memcpy(hkey->istate, SM3_INITIAL_STATE, sizeof(SM3_INITIAL_STATE));
+    SM3_Compress(hkey->istate, pad);
+
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+        pad[i] = k[i] ^ 0x5c;
+    memcpy(hkey->ostate, SM3_INITIAL_STATE, sizeof(SM3_INITIAL_STATE));
+    SM3_Compress(hkey->ostate, pad);
+
+    memset(k, 0, sizeof(k));
+    memset(pad, 0, sizeof(pad));
+
+    return SM3_SUCCESS;
+}
+
+int SM3_HMAC_ClearKey(SM3_HMAC_KEY *hkey) {
+    /* 检查输入参数 */
+    if (hkey == NULL)
+        return SM3_NULL_PTR;
+
+    memset(hkey, 0, sizeof(*hkey));
+
+    return SM3_SUCCESS;
+}
+
+int SM3_HMAC_Init(SM3_HMAC_CTX *ctx, const SM3_HMAC_KEY *hkey) {
+    /* 检查输入参数 */
+    if (ctx == NULL || hkey == NULL)
+        return SM3_NULL_PTR;
+
+    /* 内层从吸收(K ^ ipad)后的状态开始，已处理一个分组 */
+    memcpy(ctx->ctx.state, hkey->istate, sizeof(hkey->istate));
+    ctx->ctx.total_len = SM3_BLOCK_SIZE;
+    ctx->ctx.block_len = 0;
+    memcpy(ctx->ostate, hkey->ostate, sizeof(hkey->ostate));
+
+    return SM3_SUCCESS;
+}
+
+int SM3_HMAC_Update(SM3_HMAC_CTX *ctx, const uint8_t *data, size_t len) {
+    /* 检查输入参数 */
+    if (ctx == NULL)
+        return SM3_NULL_PTR;
+
+    return SM3_Update(&ctx->ctx, data, len);
+}
+
+int SM3_HMAC_Final(SM3_HMAC_CTX *ctx, uint8_t mac[SM3_DIGEST_SIZE]) {
+    uint8_t inner[SM3_DIGEST_SIZE];
+    int ret;
+
+    /* 检查输入参数 */
+    if (ctx == NULL || mac == NULL)
+        return SM3_NULL_PTR;
+
+    ret = SM3_Final(&ctx->ctx, inner);
+    if (ret != SM3_SUCCESS)
+        return ret;
+
+    /* 外层：H((K ^ opad) || inner)，只需一次压缩 */
+    memcpy(ctx->ctx.state, ctx->ostate, sizeof(ctx->ostate));
+    ctx->ctx.total_len = SM3_BLOCK_SIZE;
+    ctx->ctx.block_len = 0;
+    SM3_Update(&ctx->ctx, inner, SM3_DIGEST_SIZE);
+    ret = SM3_Final(&ctx->ctx, mac);
+
+    memset(inner, 0, sizeof(inner));
+    memset(ctx->ostate, 0, sizeof(ctx->ostate));
+    SM3_Clean(&ctx->ctx);
+
+    return ret;
+}
+
+int SM3_HMAC(const SM3_HMAC_KEY *hkey, const uint8_t *data, size_t len, uint8_t mac[SM3_DIGEST_SIZE]) {
+    SM3_HMAC_CTX ctx;
+    int ret;
+
+    ret = SM3_HMAC_Init(&ctx, hkey);
+    if (ret != SM3_SUCCESS)
+        return ret;
+
+    if (len > 0) {
+        ret = SM3_HMAC_Update(&ctx, data, len);
+        if (ret != SM3_SUCCESS)
+            return ret;
+    }
+
+    return SM3_HMAC_Final(&ctx, mac);
+}
+
 void SM3_PadMessage(SM3_CTX *ctx) {
     size_t original_len = ctx->block_len;
     uint64_t bit_len = ctx->total_len * 8; /* 转换为比特数 */
@@ -200,27 +409,12 @@ void SM3_PadMessage(SM3_CTX *ctx) {
     }
 }
 
-void SM3_Compress(uint32_t state[SM3_STATE_WORDS], const uint8_t block[SM3_BLOCK_SIZE]) {
-    uint32_t W[68];                  /* 消息扩展后的字 */
-    uint32_t W1[64];                 /* 用于压缩的字 */
+void SM3_CompressBlocks(uint32_t state[SM3_STATE_WORDS], const uint8_t *data, size_t nblocks) {
+    uint32_t W[16];                  /* 滚动的消息扩展字 */
     uint32_t A, B, C, D, E, F, G, H; /* 工作变量 */
-    uint32_t SS1, SS2, TT1, TT2;
     int j;
 
-    for (j = 0; j < 16; j++) {
-        W[j] = (uint32_t)(block[j * 4]) << 24 | (uint32_t)(block[j * 4 + 1]) << 16 | (uint32_t)(block[j * 4 + 2]) << 8 |
-               (uint32_t)(block[j * 4 + 3]);
-    }
-
-    /* 扩展16个字到68个字 */
-    for (j = 16; j < 68; j++)
-        W[j] = P1(W[j - 16] ^ W[j - 9] ^ ROTL(W[j - 3], 15)) ^ ROTL(W[j - 13], 7) ^ W[j - 6];
-
-    /* 生成W1数组 */
-    for (j = 0; j < 64; j++)
-        W1[j] = W[j] ^ W[j + 4];
-
-    /* 初始化工作变量 */
+    INSTR_ADD(INSTR_SM3_COMPRESS, nblocks);
     A = state[0];
     B = state[1];
     C = state[2];
@@ -230,39 +424,36 @@ void SM3_Compress(uint32_t state[SM3_STATE_WORDS], const uint8_t block[SM3_BLOCK
     G = state[6];
     H = state[7];
 
-    /* 压缩函数主循环 */
-    for (j = 0; j < 64; j++) {
-        /* 计算SS1和SS2 */
-        SS1 = ROTL(ROTL(A, 12) + E + ROTL(SM3_TJ[j], j), 7);
-        SS2 = SS1 ^ ROTL(A, 12);
-
-        /* 计算TT1和TT2 */
-        if (j < 16) {
-            TT1 = FF0(A, B, C) + D + SS2 + W1[j];
-            TT2 = GG0(E, F, G) + H + SS1 + W[j];
-        } else {
-            TT1 = FF1(A, B, C) + D + SS2 + W1[j];
-            TT2 = GG1(E, F, G) + H + SS1 + W[j];
+    for (; nblocks > 0; nblocks--, data += SM3_BLOCK_SIZE) {
+        for (j = 0; j < 16; j++)
+            W[j] = LOAD32_BE(data + j * 4);
+
+        /* 第0~15轮，第12轮起开始生成W[16..19] */
+        ROUNDS4(FF0, GG0, NO_EXPAND, 0, 0);
+        ROUNDS4(FF0, GG0, NO_EXPAND, 4, 4);
+        ROUNDS4(FF0, GG0, NO_EXPAND, 8, 8);
+        ROUNDS4(FF0, GG0, EXPAND, 12, 12);
+
+        /* 第16~63轮，每16轮W的下标回到原位 */
+        for (j = 16; j < 64; j += 16) {
+            ROUNDS4(FF1, GG1, EXPAND, j, 0);
+            ROUNDS4(FF1, GG1, EXPAND, j + 4, 4);
+            ROUNDS4(FF1, GG1, EXPAND, j + 8, 8);
+            ROUNDS4(FF1, GG1, EXPAND, j + 12, 12);
         }
 
-        /* 更新工作变量 */
-        D = C;
-        C = ROTL(B, 9);
-        B = A;
-        A = TT1;
-        H = G;
-        G = ROTL(F, 19);
-        F = E;
-        E = P0(TT2);
+        /* 更新状态 */
+        A = state[0] ^= A;
+        B = state[1] ^= B;
+        C = state[2] ^= C;
+        D = state[3] ^= D;
+        E = state[4] ^= E;
+        F = state[5] ^= F;
+        G = state[6] ^= G;
+        H = state[7] ^= H;
     }
+}
 
-    /* 更新状态 */
-    state[0] ^= A;
-    state[1] ^= B;
-    state[2] ^= C;
-    state[3] ^= D;
-    state[4] ^= E;
-    state[5] ^= F;
-    state[6] ^= G;
-    state[7] ^= H;
+void SM3_Compress(uint32_t state[SM3_STATE_WORDS], const uint8_t block[SM3_BLOCK_SIZE]) {
+    SM3_CompressBlocks(state, block, 1);
 }
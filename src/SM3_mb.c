@@ -0,0 +1,436 @@
+#include "SM3.h"
+#include "cpu.h"
+#include "instr.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SM3_MB_X86
+#include <immintrin.h>
+#endif
+
+#define SM3_MB_LANES 16 /* 最大并行通道数 */
+
+/* SM3初始哈希值 */
+static const uint32_t SM3_MB_IV[SM3_STATE_WORDS] = {0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
+                                                    0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e};
+
+/* 预先循环移位的轮常量：ROTL(T_j, j mod 32) */
+static const uint32_t SM3_MB_TJ[64] = {
+    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb, 0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
+    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce, 0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5,
+    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
+    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5};
+
+/* 单条消息的分组序列：[拼接首块] 原地整块 [尾块与填充] */
+typedef struct {
+    const uint8_t *data;                /* 可直接压缩的整块数据 */
+    size_t nblocks;                     /* data中剩余的整块数 */
+    int has_head;                       /* 是否有待压缩的拼接首块 */
+    uint8_t head[SM3_BLOCK_SIZE];       /* 上下文缓冲区与输入拼接成的首块 */
+    uint8_t tail[2 * SM3_BLOCK_SIZE];   /* 剩余数据与填充 */
+    size_t ntail;                       /* tail中剩余的分组数 */
+    size_t tail_pos;                    /* tail中下一分组的偏移 */
+} sm3_mb_job;
+
+/* 多通道压缩函数：state按[字][通道]存放 */
+typedef void (*sm3_mb_kernel)(uint32_t *state, const uint8_t *const blocks[]);
+
+static void sm3_mb_job_init(sm3_mb_job *job, uint32_t state[SM3_STATE_WORDS], const SM3_CTX *ctx,
+                            const uint8_t *data, size_t len) {
+    size_t buffered = 0, rem;
+    uint64_t bit_len;
+
+    if (ctx != NULL) {
+        memcpy(state, ctx->state, sizeof(ctx->state));
+        buffered = ctx->block_len;
+        bit_len = (ctx->total_len + len) * 8;
+    } else {
+        memcpy(state, SM3_MB_IV, sizeof(SM3_MB_IV));
+        bit_len = (uint64_t)len * 8;
+    }
+
+    /* 上下文中的缓冲数据与输入拼接：凑满一块则作为首块，否则并入尾块 */
+    job->has_head = 0;
+    if (buffered > 0) {
+        memcpy(job->head, ctx->block, buffered);
+        if (buffered + len >= SM3_BLOCK_SIZE) {
+            size_t fill = SM3_BLOCK_SIZE - buffered;
+            memcpy(job->head + buffered, data, fill);
+            data += fill;
+            len -= fill;
+            buffered = 0;
+            job->has_head = 1;
+        }
+    }
+
+    /* 中间的整块直接从输入中压缩，不做复制 */
+    job->data = data;
+    job->nblocks = len / SM3_BLOCK_SIZE;
+    rem = len % SM3_BLOCK_SIZE;
+
+    if (buffered > 0)
+        memcpy(job->tail, job->head, buffered);
+    if (rem > 0)
+        memcpy(job->tail + buffered, data + job->nblocks * SM3_BLOCK_SIZE, rem);
+    rem += buffered;
+
+    /* 填充：0x80、0字节与64位大端长度 */
+    job->ntail = (rem <= SM3_BLOCK_SIZE - 9) ? 1 : 2;
+    job->tail_pos = 0;
+    job->tail[rem] = 0x80;
+    memset(job->tail + rem + 1, 0, job->ntail * SM3_BLOCK_SIZE - 8 - rem - 1);
+    for (int i = 0; i < 8; i++)
+        job->tail[job->ntail * SM3_BLOCK_SIZE - 8 + i] = (bit_len >> (56 - i * 8)) & 0xFF;
+}
+
+static const uint8_t *sm3_mb_job_next(sm3_mb_job *job) {
+    const uint8_t *p;
+
+    if (job->has_head) {
+        job->has_head = 0;
+        return job->head;
+    }
+    if (job->nblocks > 0) {
+        p = job->data;
+        job->data += SM3_BLOCK_SIZE;
+        job->nblocks--;
+        return p;
+    }
+    p = job->tail + job->tail_pos;
+    job->tail_pos += SM3_BLOCK_SIZE;
+    job->ntail--;
+    return p;
+}
+
+static int sm3_mb_job_done(const sm3_mb_job *job) {
+    return !job->has_head && job->nblocks == 0 && job->ntail == 0;
+}
+
+static void sm3_mb_output(uint8_t digest[SM3_DIGEST_SIZE], const uint32_t *state, size_t lanes, size_t lane) {
+    for (int i = 0; i < SM3_STATE_WORDS; i++) {
+        uint32_t w = state[i * lanes + lane];
+        digest[i * 4] = (w >> 24) & 0xFF;
+        digest[i * 4 + 1] = (w >> 16) & 0xFF;
+        digest[i * 4 + 2] = (w >> 8) & 0xFF;
+        digest[i * 4 + 3] = w & 0xFF;
+    }
+}
+
+/*
+ * 多缓冲区调度：每个通道处理一条消息，通道空闲时立即装入下一条消息，
+ * 长短不一的消息也能保持通道占满。空闲通道压缩一个全零块，其结果被丢弃。
+ */
+static void sm3_mb_run(sm3_mb_kernel kernel, size_t lanes, const SM3_CTX *const ctx[], const uint8_t *const data[],
+                       const size_t len[], size_t n, uint8_t digest[][SM3_DIGEST_SIZE]) {
+    static const uint8_t zero[SM3_BLOCK_SIZE];
+    uint32_t state[SM3_STATE_WORDS * SM3_MB_LANES] __attribute__((aligned(64)));
+    uint32_t iv[SM3_STATE_WORDS];
+    sm3_mb_job job[SM3_MB_LANES];
+    const uint8_t *blocks[SM3_MB_LANES];
+    size_t msg[SM3_MB_LANES];
+    int active[SM3_MB_LANES] = {0};
+    size_t next = 0, nactive = 0, l;
+    int i;
+
+    for (;;) {
+        /* 空闲通道装入下一条消息 */
+        for (l = 0; l < lanes && next < n; l++) {
+            if (active[l])
+                continue;
+            sm3_mb_job_init(&job[l], iv, ctx != NULL ? ctx[next] : NULL, data[next], len[next]);
+            for (i = 0; i < SM3_STATE_WORDS; i++)
+                state[i * lanes + l] = iv[i];
+            msg[l] = next++;
+            active[l] = 1;
+            nactive++;
+        }
+
+        if (nactive == 0)
+            break;
+
+        /* 只剩最后一条消息时改用标量压缩，避免空转其余通道 */
+        if (nactive == 1 && next == n) {
+            for (l = 0; !active[l]; l++)
+                ;
+            for (i = 0; i < SM3_STATE_WORDS; i++)
+                iv[i] = state[i * lanes + l];
+            while (!sm3_mb_job_done(&job[l]))
+                SM3_Compress(iv, sm3_mb_job_next(&job[l]));
+            sm3_mb_output(digest[msg[l]], iv, 1, 0);
+            break;
+        }
+
+        for (l = 0; l < lanes; l++)
+            blocks[l] = active[l] ? sm3_mb_job_next(&job[l]) : zero;
+
+        kernel(state, blocks);
+        INSTR_ADD(INSTR_SM3_COMPRESS, nactive);
+
+        for (l = 0; l < lanes; l++) {
+            if (active[l] && sm3_mb_job_done(&job[l])) {
+                sm3_mb_output(digest[msg[l]], state, lanes, l);
+                active[l] = 0;
+                nactive--;
+            }
+        }
+    }
+}
+
+#ifdef SM3_MB_X86
+
+/* AVX2：8通道 */
+#define ROTL8(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define P0_8(x)     _mm256_xor_si256(_mm256_xor_si256(x, ROTL8(x, 9)), ROTL8(x, 17))
+#define P1_8(x)     _mm256_xor_si256(_mm256_xor_si256(x, ROTL8(x, 15)), ROTL8(x, 23))
+#define XOR3_8(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define MAJ_8(x, y, z)  _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(_mm256_or_si256(x, y), z))
+#define CH_8(x, y, z)   _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+
+#define EXPAND8(W, j)                                                                                                  \
+    W[((j) + 4) & 15] = _mm256_xor_si256(                                                                              \
+        _mm256_xor_si256(P1_8(XOR3_8(W[((j) + 4) & 15], W[((j) + 11) & 15], ROTL8(W[((j) + 1) & 15], 15))),          \
+                         ROTL8(W[((j) + 7) & 15], 7)),                                                                 \
+        W[((j) + 14) & 15])
+
+#define ROUND8(FF, GG, W, j)                                                                                           \
+    do {                                                                                                               \
+        __m256i a12 = ROTL8(A, 12);                                                                                    \
+        __m256i ss1 = _mm256_add_epi32(_mm256_add_epi32(a12, E), _mm256_set1_epi32((int)SM3_MB_TJ[j]));               \
+        ss1 = ROTL8(ss1, 7);                                                                                           \
+        __m256i ss2 = _mm256_xor_si256(ss1, a12);                                                                      \
+        __m256i w1 = _mm256_xor_si256(W[(j) & 15], W[((j) + 4) & 15]);                                                 \
+        __m256i tt1 = _mm256_add_epi32(_mm256_add_epi32(FF(A, B, C), D), _mm256_add_epi32(ss2, w1));                   \
+        __m256i tt2 = _mm256_add_epi32(_mm256_add_epi32(GG(E, F, G), H), _mm256_add_epi32(ss1, W[(j) & 15]));          \
+        D = C;                                                                                                         \
+        C = ROTL8(B, 9);                                                                                               \
+        B = A;                                                                                                         \
+        A = tt1;                                                                                                       \
+        H = G;                                                                                                         \
+        G = ROTL8(F, 19);                                                                                              \
+        F = E;                                                                                                         \
+        E = P0_8(tt2);                                                                                                 \
+    } while (0)
+
+__attribute__((target("avx2"))) static void sm3_mb_load8(__m256i W[8], const uint8_t *const blocks[], size_t off) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5,
+                                           4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i r[8], t[8], u[8];
+    int l;
+
+    for (l = 0; l < 8; l++)
+        r[l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(blocks[l] + off)), bswap);
+
+    /* 8x8转置：W[k]为各通道的第k个字 */
+    for (l = 0; l < 8; l += 2) {
+        t[l] = _mm256_unpacklo_epi32(r[l], r[l + 1]);
+        t[l + 1] = _mm256_unpackhi_epi32(r[l], r[l + 1]);
+    }
+    for (l = 0; l < 8; l += 4) {
+        u[l] = _mm256_unpacklo_epi64(t[l], t[l + 2]);
+        u[l + 1] = _mm256_unpackhi_epi64(t[l], t[l + 2]);
+        u[l + 2] = _mm256_unpacklo_epi64(t[l + 1], t[l + 3]);
+        u[l + 3] = _mm256_unpackhi_epi64(t[l + 1], t[l + 3]);
+    }
+    for (l = 0; l < 4; l++) {
+        W[l] = _mm256_permute2x128_si256(u[l], u[l + 4], 0x20);
+        W[l + 4] = _mm256_permute2x128_si256(u[l], u[l + 4], 0x31);
+    }
+}
+
+__attribute__((target("avx2"))) static void sm3_mb_compress_avx2(uint32_t *state, const uint8_t *const blocks[]) {
+    __m256i A, B, C, D, E, F, G, H, W[16];
+    __m256i *S = (__m256i *)state;
+    int j;
+
+    sm3_mb_load8(W, blocks, 0);
+    sm3_mb_load8(W + 8, blocks, 32);
+
+    A = _mm256_load_si256(S + 0);
+    B = _mm256_load_si256(S + 1);
+    C = _mm256_load_si256(S + 2);
+    D = _mm256_load_si256(S + 3);
+    E = _mm256_load_si256(S + 4);
+    F = _mm256_load_si256(S + 5);
+    G = _mm256_load_si256(S + 6);
+    H = _mm256_load_si256(S + 7);
+
+    /* 消息扩展随轮次滚动进行，W只保留16个字 */
+    for (j = 0; j < 12; j++)
+        ROUND8(XOR3_8, XOR3_8, W, j);
+    for (; j < 16; j++) {
+        EXPAND8(W, j);
+        ROUND8(XOR3_8, XOR3_8, W, j);
+    }
+    for (; j < 64; j++) {
+        EXPAND8(W, j);
+        ROUND8(MAJ_8, CH_8, W, j);
+    }
+
+    _mm256_store_si256(S + 0, _mm256_xor_si256(A, _mm256_load_si256(S + 0)));
+    _mm256_store_si256(S + 1, _mm256_xor_si256(B, _mm256_load_si256(S + 1)));
+    _mm256_store_si256(S + 2, _mm256_xor_si256(C, _mm256_load_si256(S + 2)));
+    _mm256_store_si256(S + 3, _mm256_xor_si256(D, _mm256_load_si256(S + 3)));
+    _mm256_store_si256(S + 4, _mm256_xor_si256(E, _mm256_load_si256(S + 4)));
+    _mm256_store_si256(S + 5, _mm256_xor_si256(F, _mm256_load_si256(S + 5)));
+    _mm256_store_si256(S + 6, _mm256_xor_si256(G, _mm256_load_si256(S + 6)));
+    _mm256_store_si256(S + 7, _mm256_xor_si256(H, _mm256_load_si256(S + 7)));
+}
+
+/* AVX-512：16通道，循环移位与三输入布尔函数各用一条指令 */
+#define ROTL16(x, n)     _mm512_rol_epi32(x, n)
+#define P0_16(x)         _mm512_ternarylogic_epi32(x, ROTL16(x, 9), ROTL16(x, 17), 0x96)
+#define P1_16(x)         _mm512_ternarylogic_epi32(x, ROTL16(x, 15), ROTL16(x, 23), 0x96)
+#define XOR3_16(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define MAJ_16(x, y, z)  _mm512_ternarylogic_epi32(x, y, z, 0xE8)
+#define CH_16(x, y, z)   _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+
+#define EXPAND16(W, j)                                                                                                 \
+    W[((j) + 4) & 15] = XOR3_16(P1_16(XOR3_16(W[((j) + 4) & 15], W[((j) + 11) & 15], ROTL16(W[((j) + 1) & 15], 15))), \
+                                ROTL16(W[((j) + 7) & 15], 7), W[((j) + 14) & 15])
+
+#define ROUND16(FF, GG, W, j)                                                                                          \
+    do {                                                                                                               \
+        __m512i a12 = ROTL16(A, 12);                                                                                   \
+        __m512i ss1 = _mm512_add_epi32(_mm512_add_epi32(a12, E), _mm512_set1_epi32((int)SM3_MB_TJ[j]));               \
+        ss1 = ROTL16(ss1, 7);                                                                                          \
+        __m512i ss2 = _mm512_xor_si512(ss1, a12);                                                                      \
+        __m512i w1 = _mm512_xor_si512(W[(j) & 15], W[((j) + 4) & 15]);                                                 \
+        __m512i tt1 = _mm512_add_epi32(_mm512_add_epi32(FF(A, B, C), D), _mm512_add_epi32(ss2, w1));                   \
+        __m512i tt2 = _mm512_add_epi32(_mm512_add_epi32(GG(E, F, G), H), _mm512_add_epi32(ss1, W[(j) & 15]));          \
+        D = C;                                                                                                         \
+        C = ROTL16(B, 9);                                                                                              \
+        B = A;                                                                                                         \
+        A = tt1;                                                                                                       \
+        H = G;                                                                                                         \
+        G = ROTL16(F, 19);                                                                                             \
+        F = E;                                                                                                         \
+        E = P0_16(tt2);                                                                                                \
+    } while (0)
+
+__attribute__((target("avx512f,avx512bw"))) static void sm3_mb_load16(__m512i W[16], const uint8_t *const blocks[]) {
+    const __m512i bswap = _mm512_set4_epi32(0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203);
+    __m512i r[16], t[16], u[16], lo, hi, lo2, hi2;
+    int l, k;
+
+    for (l = 0; l < 16; l++)
+        r[l] = _mm512_shuffle_epi8(_mm512_loadu_si512((const void *)blocks[l]), bswap);
+
+    /* 16x16转置：先在128位内转置4x4，再按128位块重排 */
+    for (l = 0; l < 16; l += 2) {
+        t[l] = _mm512_unpacklo_epi32(r[l], r[l + 1]);
+        t[l + 1] = _mm512_unpackhi_epi32(r[l], r[l + 1]);
+    }
+    for (l = 0; l < 16; l += 4) {
+        u[l] = _mm512_unpacklo_epi64(t[l], t[l + 2]);
+        u[l + 1] = _mm512_unpackhi_epi64(t[l], t[l + 2]);
+        u[l + 2] = _mm512_unpacklo_epi64(t[l + 1], t[l + 3]);
+        u[l + 3] = _mm512_unpackhi_epi64(t[l + 1], t[l + 3]);
+    }
+    for (k = 0; k < 4; k++) {
+        lo = _mm512_shuffle_i32x4(u[k], u[k + 4], 0x88);
+        hi = _mm512_shuffle_i32x4(u[k], u[k + 4], 0xDD);
+        lo2 = _mm512_shuffle_i32x4(u[k + 8], u[k + 12], 0x88);
+        hi2 = _mm512_shuffle_i32x4(u[k + 8], u[k + 12], 0xDD);
+        W[k] = _mm512_shuffle_i32x4(lo, lo2, 0x88);
+        W[k + 8] = _mm512_shuffle_i32x4(lo, lo2, 0xDD);
+        W[k + 4] = _mm512_shuffle_i32x4(hi, hi2, 0x88);
+        W[k + 12] = _mm512_shuffle_i32x4(hi, hi2, 0xDD);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void sm3_mb_compress_avx512(uint32_t *state,
+                                                                              const uint8_t *const blocks[]) {
+    __m512i A, B, C, D, E, F, G, H, W[16];
+    __m512i *S = (__m512i *)state;
+    int j;
+
+    sm3_mb_load16(W, blocks);
+
+    A = _mm512_load_si512(S + 0);
+    B = _mm512_load_si512(S + 1);
+    C = _mm512_load_si512(S + 2);
+    D = _mm512_load_si512(S + 3);
+    E = _mm512_load_si512(S + 4);
+    F = _mm512_load_si512(S + 5);
+    G = _mm512_load_si512(S + 6);
+    H = _mm512_load_si512(S + 7);
+
+    for (j = 0; j < 12; j++)
+        ROUND16(XOR3_16, XOR3_16, W, j);
+    for (; j < 16; j++) {
+        EXPAND16(W, j);
+        ROUND16(XOR3_16, XOR3_16, W, j);
+    }
+    for (; j < 64; j++) {
+        EXPAND16(W, j);
+        ROUND16(MAJ_16, CH_16, W, j);
+    }
+
+    _mm512_store_si512(S + 0, _mm512_xor_si512(A, _mm512_load_si512(S + 0)));
+    _mm512_store_si512(S + 1, _mm512_xor_si512(B, _mm512_load_si512(S + 1)));
+    _mm512_store_si512(S + 2, _mm512_xor_si512(C, _mm512_load_si512(S + 2)));
+    _mm512_store_si512(S + 3, _mm512_xor_si512(D, _mm512_load_si512(S + 3)));
+    _mm512_store_si512(S + 4, _mm512_xor_si512(E, _mm512_load_si512(S + 4)));
+    _mm512_store_si512(S + 5, _mm512_xor_si512(F, _mm512_load_si512(S + 5)));
+    _mm512_store_si512(S + 6, _mm512_xor_si512(G, _mm512_load_si512(S + 6)));
+    _mm512_store_si512(S + 7, _mm512_xor_si512(H, _mm512_load_si512(S + 7)));
+}
+
+#endif /* SM3_MB_X86 */
+
+static int sm3_mb_dispatch(const SM3_CTX *const ctx[], const uint8_t *const data[], const size_t len[], size_t n,
+                           uint8_t digest[][SM3_DIGEST_SIZE]) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if ((data[i] == NULL && len[i] > 0) || (ctx != NULL && ctx[i] == NULL))
+            return SM3_NULL_PTR;
+    }
+
+#ifdef SM3_MB_X86
+    unsigned int features = cpu_features();
+
+    if (n > 8 && (features & (CPU_AVX512F | CPU_AVX512BW)) == (CPU_AVX512F | CPU_AVX512BW)) {
+        sm3_mb_run(sm3_mb_compress_avx512, 16, ctx, data, len, n, digest);
+        return SM3_SUCCESS;
+    }
+    if (n > 1 && (features & CPU_AVX2)) {
+        sm3_mb_run(sm3_mb_compress_avx2, 8, ctx, data, len, n, digest);
+        return SM3_SUCCESS;
+    }
+#endif
+
+    /* 标量回退 */
+    for (i = 0; i < n; i++) {
+        SM3_CTX sm3_ctx;
+        if (ctx != NULL)
+            sm3_ctx = *ctx[i];
+        else
+            SM3_Init(&sm3_ctx);
+        if (len[i] > 0)
+            SM3_Update(&sm3_ctx, data[i], len[i]);
+        SM3_Final(&sm3_ctx, digest[i]);
+    }
+    return SM3_SUCCESS;
+}
+
+int SM3_MultiBuffer(const uint8_t *const data[], const size_t len[], size_t n, uint8_t digest[][SM3_DIGEST_SIZE]) {
+    /* 检查输入参数 */
+    if (data == NULL || len == NULL || digest == NULL)
+        return SM3_NULL_PTR;
+
+    return sm3_mb_dispatch(NULL, data, len, n, digest);
+}
+
+int SM3_MultiBufferFinal(const SM3_CTX *const ctx[], const uint8_t *const data[], const size_t len[], size_t n,
+                         uint8_t digest[][SM3_DIGEST_SIZE]) {
+    /* 检查输入参数 */
+    if (ctx == NULL || data == NULL || len == NULL || digest == NULL)
+        return SM3_NULL_PTR;
+
+    return sm3_mb_dispatch(ctx, data, len, n, digest);
+}
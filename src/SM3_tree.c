@@ -0,0 +1,225 @@
+#include "SM3_tree.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SM3_TREE_LEAF   0x00 /* 叶子前缀 */
+#define SM3_TREE_NODE   0x01 /* 内部节点前缀 */
+#define SM3_TREE_ROOT   0x02 /* 最终输出前缀 */
+#define SM3_TREE_LANES  16   /* 每批并行哈希的叶子数 */
+
+/* 叶子上下文：已吸收前缀0x00 */
+static void sm3_tree_leaf_init(SM3_CTX *ctx) {
+    static const uint8_t prefix = SM3_TREE_LEAF;
+    SM3_Init(ctx);
+    SM3_Update(ctx, &prefix, 1);
+}
+
+static void sm3_tree_node(uint8_t out[SM3_DIGEST_SIZE], const uint8_t left[SM3_DIGEST_SIZE],
+                          const uint8_t right[SM3_DIGEST_SIZE]) {
+    uint8_t buf[1 + 2 * SM3_DIGEST_SIZE];
+
+    buf[0] = SM3_TREE_NODE;
+    memcpy(buf + 1, left, SM3_DIGEST_SIZE);
+    memcpy(buf + 1 + SM3_DIGEST_SIZE, right, SM3_DIGEST_SIZE);
+    SM3(buf, sizeof(buf), out);
+}
+
+/* 压入第(leaves + 1)个叶子，并合并所有已成满二叉树的相邻子树 */
+static void sm3_tree_push(SM3_TREE_CTX *ctx, const uint8_t leaf[SM3_DIGEST_SIZE]) {
+    uint64_t count;
+
+    memcpy(ctx->stack[ctx->depth++], leaf, SM3_DIGEST_SIZE);
+    for (count = ++ctx->leaves; (count & 1) == 0; count >>= 1) {
+        ctx->depth--;
+        sm3_tree_node(ctx->stack[ctx->depth - 1], ctx->stack[ctx->depth - 1], ctx->stack[ctx->depth]);
+    }
+}
+
+/* 自右向左合并栈中剩余子树，输出最终摘要 */
+static void sm3_tree_finish(SM3_TREE_CTX *ctx, uint8_t digest[SM3_DIGEST_SIZE]) {
+    uint8_t buf[1 + SM3_DIGEST_SIZE + 8];
+
+    while (ctx->depth > 1) {
+        ctx->depth--;
+        sm3_tree_node(ctx->stack[ctx->depth - 1], ctx->stack[ctx->depth - 1], ctx->stack[ctx->depth]);
+    }
+
+    buf[0] = SM3_TREE_ROOT;
+    memcpy(buf + 1, ctx->stack[0], SM3_DIGEST_SIZE);
+    for (int i = 0; i < 8; i++)
+        buf[1 + SM3_DIGEST_SIZE + i] = (ctx->total_len >> (56 - i * 8)) & 0xFF;
+    SM3(buf, sizeof(buf), digest);
+}
+
+int SM3_Tree_Init(SM3_TREE_CTX *ctx) {
+    /* 检查输入参数 */
+    if (ctx == NULL)
+        return SM3_NULL_PTR;
+
+    sm3_tree_leaf_init(&ctx->leaf);
+    ctx->leaf_len = 0;
+    ctx->leaves = 0;
+    ctx->total_len = 0;
+    ctx->depth = 0;
+
+    return SM3_SUCCESS;
+}
+
+int SM3_Tree_Update(SM3_TREE_CTX *ctx, const uint8_t *data, size_t len) {
+    uint8_t leaf[SM3_DIGEST_SIZE];
+
+    /* 检查输入参数 */
+    if (ctx == NULL || data == NULL)
+        return SM3_NULL_PTR;
+
+    ctx->total_len += len;
+    while (len > 0) {
+        size_t n = SM3_TREE_LEAF_SIZE - ctx->leaf_len;
+        if (n > len)
+            n = len;
+
+        SM3_Update(&ctx->leaf, data, n);
+        ctx->leaf_len += n;
+        data += n;
+        len -= n;
+
+        /* 叶子已满：输出叶子摘要并开始下一个叶子 */
+        if (ctx->leaf_len == SM3_TREE_LEAF_SIZE) {
+            SM3_Final(&ctx->leaf, leaf);
+            sm3_tree_push(ctx, leaf);
+            sm3_tree_leaf_init(&ctx->leaf);
+            ctx->leaf_len = 0;
+        }
+    }
+
+    return SM3_SUCCESS;
+}
+
+int SM3_Tree_Final(SM3_TREE_CTX *ctx, uint8_t digest[SM3_DIGEST_SIZE]) {
+    uint8_t leaf[SM3_DIGEST_SIZE];
+
+    /* 检查输入参数 */
+    if (ctx == NULL || digest == NULL)
+        return SM3_NULL_PTR;
+
+    /* 未满的最后一个叶子；空输入也算一个叶子 */
+    if (ctx->leaf_len > 0 || ctx->leaves == 0) {
+        SM3_Final(&ctx->leaf, leaf);
+        sm3_tree_push(ctx, leaf);
+    }
+    sm3_tree_finish(ctx, digest);
+    SM3_Clean(&ctx->leaf);
+
+    return SM3_SUCCESS;
+}
+
+/* 工作线程的任务：计算一段连续叶子的摘要 */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t first;                        /* 第一个叶子的序号 */
+    size_t count;                        /* 叶子数 */
+    uint8_t (*digest)[SM3_DIGEST_SIZE];  /* 全部叶子摘要数组 */
+    int ret;
+} sm3_tree_job;
+
+static void *sm3_tree_worker(void *arg) {
+    sm3_tree_job *job = arg;
+    const uint8_t *leaf[SM3_TREE_LANES];
+    const SM3_CTX *ctx[SM3_TREE_LANES];
+    size_t leaf_len[SM3_TREE_LANES];
+    SM3_CTX prefix;
+    size_t i, n;
+
+    /* 所有叶子共享已吸收0x00前缀的上下文，在多缓冲区SM3的通道中并行哈希 */
+    sm3_tree_leaf_init(&prefix);
+    for (i = 0; i < SM3_TREE_LANES; i++)
+        ctx[i] = &prefix;
+
+    job->ret = SM3_SUCCESS;
+    for (i = 0; i < job->count; i += n) {
+        n = job->count - i < SM3_TREE_LANES ? job->count - i : SM3_TREE_LANES;
+        for (size_t l = 0; l < n; l++) {
+            size_t off = (job->first + i + l) * SM3_TREE_LEAF_SIZE;
+            leaf[l] = job->data + off;
+            leaf_len[l] = job->len - off < SM3_TREE_LEAF_SIZE ? job->len - off : SM3_TREE_LEAF_SIZE;
+        }
+        job->ret = SM3_MultiBufferFinal(ctx, leaf, leaf_len, n, job->digest + job->first + i);
+        if (job->ret != SM3_SUCCESS)
+            break;
+    }
+
+    return NULL;
+}
+
+int SM3_Tree(const uint8_t *data, size_t len, int threads, uint8_t digest[SM3_DIGEST_SIZE]) {
+    SM3_TREE_CTX ctx;
+    sm3_tree_job *jobs;
+    pthread_t *tids;
+    uint8_t (*leaves)[SM3_DIGEST_SIZE];
+    size_t nleaves, per, i;
+    int t, started, ret = SM3_SUCCESS;
+
+    /* 检查输入参数 */
+    if ((data == NULL && len > 0) || digest == NULL)
+        return SM3_NULL_PTR;
+
+    if (len == 0) {
+        SM3_Tree_Init(&ctx);
+        return SM3_Tree_Final(&ctx, digest);
+    }
+
+    nleaves = (len + SM3_TREE_LEAF_SIZE - 1) / SM3_TREE_LEAF_SIZE;
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)threads > nleaves)
+        threads = (int)nleaves;
+
+    leaves = malloc(nleaves * SM3_DIGEST_SIZE);
+    jobs = malloc(threads * sizeof(sm3_tree_job));
+    tids = malloc(threads * sizeof(pthread_t));
+    if (leaves == NULL || jobs == NULL || tids == NULL) {
+        free(leaves);
+        free(jobs);
+        free(tids);
+        return SM3_INTERNAL_ERROR;
+    }
+
+    /* 叶子按连续区间均分给各线程，第0段在调用线程中计算 */
+    per = (nleaves + threads - 1) / threads;
+    for (t = 0; t < threads; t++) {
+        jobs[t].data = data;
+        jobs[t].len = len;
+        jobs[t].first = t * per < nleaves ? t * per : nleaves;
+        jobs[t].count = jobs[t].first + per < nleaves ? per : nleaves - jobs[t].first;
+        jobs[t].digest = leaves;
+        jobs[t].ret = SM3_SUCCESS;
+    }
+
+    for (started = 1; started < threads; started++)
+        if (pthread_create(&tids[started], NULL, sm3_tree_worker, &jobs[started]) != 0)
+            break;
+    /* 线程创建失败时，未能启动的各段也在调用线程中计算 */
+    sm3_tree_worker(&jobs[0]);
+    for (t = started; t < threads; t++)
+        sm3_tree_worker(&jobs[t]);
+    for (t = 1; t < started; t++)
+        pthread_join(tids[t], NULL);
+    for (t = 0; t < threads && ret == SM3_SUCCESS; t++)
+        ret = jobs[t].ret;
+
+    /* 按固定顺序合并叶子摘要 */
+    if (ret == SM3_SUCCESS) {
+        SM3_Tree_Init(&ctx);
+        ctx.total_len = len;
+        for (i = 0; i < nleaves; i++)
+            sm3_tree_push(&ctx, leaves[i]);
+        sm3_tree_finish(&ctx, digest);
+    }
+
+    free(leaves);
+    free(jobs);
+    free(tids);
+    return ret;
+}
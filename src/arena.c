@@ -0,0 +1,27 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static _Thread_local uint8_t arena_thread_buf[ARENA_THREAD_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+static _Thread_local arena arena_thread_st;
+
+void arena_init(arena *a, void *buf, size_t size) {
+    uintptr_t p = (uintptr_t)buf;
+    size_t pad = (ARENA_ALIGN - p % ARENA_ALIGN) % ARENA_ALIGN;
+
+    a->buf = (uint8_t *)buf + pad;
+    a->size = size > pad ? (size - pad) & ~(size_t)(ARENA_ALIGN - 1) : 0;
+    a->top = 0;
+}
+
+arena *arena_thread(void) {
+    /* TLS变量的地址不是常量，首次使用时再绑定缓冲区 */
+    if (arena_thread_st.buf == NULL)
+        arena_init(&arena_thread_st, arena_thread_buf, sizeof(arena_thread_buf));
+    return &arena_thread_st;
+}
+
+void arena_overflow(const arena *a, size_t size) {
+    fprintf(stderr, "arena: out of scratch memory (%zu used of %zu, %zu requested)\n", a->top, a->size, size);
+    abort();
+}
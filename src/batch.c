@@ -0,0 +1,441 @@
+#include "batch.h"
+#include "cpu.h"
+#include "instr.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86
+#include <immintrin.h>
+#endif
+
+#define BATCH_ROW(v, i, stride) ((v) + (size_t)(i) * (stride))
+
+size_t point_batch_bytes(size_t n) {
+    size_t stride = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    return 3 * FP_DIGS * stride * sizeof(uint64_t) + ARENA_ALIGN;
+}
+
+void point_batch_init(point_batch *b, arena *ar, size_t n) {
+    size_t stride = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    size_t row = stride * sizeof(uint64_t);
+    uint64_t *buf;
+
+    /* 三个坐标一次分配，行长为64字节的倍数，故每行都保持对齐 */
+    buf = (uint64_t *)arena_alloc(ar, 3 * FP_DIGS * row);
+    b->n = n;
+    b->stride = stride;
+    b->x = buf;
+    b->y = buf + FP_DIGS * stride;
+    b->z = buf + 2 * FP_DIGS * stride;
+
+    /* 补齐的通道参与批量运算，清零以免读到未初始化的内存 */
+    if (stride > n)
+        for (int i = 0; i < 3 * FP_DIGS; i++)
+            memset(BATCH_ROW(buf, i, stride) + n, 0, (stride - n) * sizeof(uint64_t));
+}
+
+void point_batch_pack(point_batch *b, const point *pts, const fp_ctx *ctx) {
+    fp_t t;
+
+    for (size_t j = 0; j < b->n; j++) {
+        if (point_is_infty(&pts[j])) {
+            fp_vec_set(b->x, b->stride, j, ctx->one);
+            fp_vec_set(b->y, b->stride, j, ctx->one);
+            memset(t, 0, sizeof(t));
+            fp_vec_set(b->z, b->stride, j, t);
+            continue;
+        }
+        fp_from_bn(t, pts[j].x, ctx);
+        fp_vec_set(b->x, b->stride, j, t);
+        fp_from_bn(t, pts[j].y, ctx);
+        fp_vec_set(b->y, b->stride, j, t);
+        fp_vec_set(b->z, b->stride, j, ctx->one);
+    }
+}
+
+void point_batch_unpack(point *pts, const point_batch *b, const fp_ctx *ctx, arena *ar) {
+    size_t mark = arena_mark(ar);
+    uint64_t *zi = (uint64_t *)arena_alloc(ar, FP_DIGS * b->stride * sizeof(uint64_t));
+    fp_t t, u, zz;
+
+    // 1/Z共用一次求逆，Z = 0（无穷远点）得到0
+    fp_vec_inv(zi, b->z, b->n, b->stride, ctx, ar);
+
+    for (size_t j = 0; j < b->n; j++) {
+        point_new(&pts[j]);
+        fp_vec_get(t, zi, b->stride, j);
+        if (fp_is_zero(t))
+            continue;
+        // x = X / Z^2, y = Y / Z^3
+        fp_sqr(zz, t, ctx);
+        fp_vec_get(u, b->x, b->stride, j);
+        fp_mul(u, u, zz, ctx);
+        fp_to_bn(pts[j].x, u, ctx);
+        fp_mul(zz, zz, t, ctx);
+        fp_vec_get(u, b->y, b->stride, j);
+        fp_mul(u, u, zz, ctx);
+        fp_to_bn(pts[j].y, u, ctx);
+    }
+    arena_release(ar, mark);
+}
+
+/*
+ * 下面的批量运算以BATCH_LANES个元素为一组，组内按“分量-通道”两层循环，
+ * 内层对各通道做相同的运算且无分支，编译器可将其展开为向量指令。
+ */
+
+void fp_vec_add(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx) {
+    for (size_t j0 = 0; j0 < n; j0 += BATCH_LANES) {
+        uint64_t s[FP_DIGS][BATCH_LANES], carry[BATCH_LANES], borrow[BATCH_LANES];
+        int i, l;
+
+        // s = a + b
+        for (l = 0; l < BATCH_LANES; l++)
+            carry[l] = 0;
+        for (i = 0; i < FP_DIGS; i++) {
+            const uint64_t *ra = BATCH_ROW(a, i, stride) + j0, *rb = BATCH_ROW(b, i, stride) + j0;
+            for (l = 0; l < BATCH_LANES; l++) {
+                uint64_t t = ra[l] + carry[l];
+                uint64_t r = t + rb[l];
+                carry[l] = (t < carry[l]) | (r < t);
+                s[i][l] = r;
+            }
+        }
+
+        // c = s - m，若不借位（或s超出256位）则取差，否则取s
+        for (l = 0; l < BATCH_LANES; l++)
+            borrow[l] = 0;
+        for (i = 0; i < FP_DIGS; i++) {
+            uint64_t *rc = BATCH_ROW(c, i, stride) + j0, m = ctx->m[i];
+            for (l = 0; l < BATCH_LANES; l++) {
+                uint64_t t = s[i][l] - m;
+                uint64_t r = t - borrow[l];
+                borrow[l] = (s[i][l] < m) | (t < borrow[l]);
+                rc[l] = r;
+            }
+        }
+        for (i = 0; i < FP_DIGS; i++) {
+            uint64_t *rc = BATCH_ROW(c, i, stride) + j0;
+            for (l = 0; l < BATCH_LANES; l++) {
+                uint64_t keep = 0 - (borrow[l] & (carry[l] ^ 1));
+                rc[l] = (s[i][l] & keep) | (rc[l] & ~keep);
+            }
+        }
+    }
+}
+
+void fp_vec_sub(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx) {
+    for (size_t j0 = 0; j0 < n; j0 += BATCH_LANES) {
+        uint64_t s[FP_DIGS][BATCH_LANES], borrow[BATCH_LANES], carry[BATCH_LANES];
+        int i, l;
+
+        // s = a - b
+        for (l = 0; l < BATCH_LANES; l++)
+            borrow[l] = 0;
+        for (i = 0; i < FP_DIGS; i++) {
+            const uint64_t *ra = BATCH_ROW(a, i, stride) + j0, *rb = BATCH_ROW(b, i, stride) + j0;
+            for (l = 0; l < BATCH_LANES; l++) {
+                uint64_t t = ra[l] - rb[l];
+                uint64_t r = t - borrow[l];
+                borrow[l] = (ra[l] < rb[l]) | (t < borrow[l]);
+                s[i][l] = r;
+            }
+        }
+
+        // 借位时加回m
+        for (l = 0; l < BATCH_LANES; l++)
+            carry[l] = 0;
+        for (i = 0; i < FP_DIGS; i++) {
+            uint64_t *rc = BATCH_ROW(c, i, stride) + j0;
+            for (l = 0; l < BATCH_LANES; l++) {
+                uint64_t m = ctx->m[i] & (0 - borrow[l]);
+                uint64_t t = s[i][l] + carry[l];
+                uint64_t r = t + m;
+                carry[l] = (t < carry[l]) | (r < t);
+                rc[l] = r;
+            }
+        }
+    }
+}
+
+/* 标量回退：逐个元素做Montgomery乘法 */
+static void fp_vec_mul_c(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride,
+                         const fp_ctx *ctx) {
+    fp_t x, y;
+
+    for (size_t j = 0; j < n; j++) {
+        fp_vec_get(x, a, stride, j);
+        fp_vec_get(y, b, stride, j);
+        fp_mul(x, x, y, ctx);
+        fp_vec_set(c, stride, j, x);
+    }
+}
+
+#ifdef BATCH_X86
+
+/*
+ * 向量化的Montgomery乘法。两个内核都把64位分量换成较窄的分量（IFMA为5×52位，AVX2为9×29位），
+ * 先算完整乘积，再逐个分量消去低位：每步u = t_i * (-m^-1) mod 2^w，t += u * m * 2^(w*i)。
+ * 为与标量的R = 2^256一致，最后一步只消去剩余的位数（52×4 + 48 = 29×8 + 24 = 256），
+ * 因此结果与fp_mul相同，均为 a * b * 2^-256 mod m。结果小于2m，最后做一次无分支的减法。
+ */
+
+#define FP52_MASK ((1ULL << 52) - 1)
+
+/* 8通道，5×52位分量，使用vpmadd52luq/vpmadd52huq */
+__attribute__((target("avx512f,avx512ifma"))) static void fp_vec_mul_ifma(uint64_t *c, const uint64_t *a,
+                                                                          const uint64_t *b, size_t n,
+                                                                          size_t stride, const fp_ctx *ctx) {
+    const __m512i mask52 = _mm512_set1_epi64(FP52_MASK);
+    const __m512i mask48 = _mm512_set1_epi64((1LL << 48) - 1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i n0 = _mm512_set1_epi64(ctx->n0 & FP52_MASK);
+    const uint64_t *p = ctx->m;
+    __m512i m[5];
+
+    m[0] = _mm512_set1_epi64(p[0] & FP52_MASK);
+    m[1] = _mm512_set1_epi64(((p[0] >> 52) | (p[1] << 12)) & FP52_MASK);
+    m[2] = _mm512_set1_epi64(((p[1] >> 40) | (p[2] << 24)) & FP52_MASK);
+    m[3] = _mm512_set1_epi64(((p[2] >> 28) | (p[3] << 36)) & FP52_MASK);
+    m[4] = _mm512_set1_epi64(p[3] >> 16);
+
+    for (size_t j0 = 0; j0 < n; j0 += BATCH_LANES) {
+        __m512i v[FP_DIGS], x[5], y[5], t[10], r[5], d[5], u, borrow;
+        int i, k;
+
+        // 64位分量 -> 52位分量
+        for (i = 0; i < FP_DIGS; i++)
+            v[i] = _mm512_loadu_si512((const void *)(BATCH_ROW(a, i, stride) + j0));
+        x[0] = _mm512_and_si512(v[0], mask52);
+        x[1] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[0], 52), _mm512_slli_epi64(v[1], 12)), mask52);
+        x[2] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[1], 40), _mm512_slli_epi64(v[2], 24)), mask52);
+        x[3] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[2], 28), _mm512_slli_epi64(v[3], 36)), mask52);
+        x[4] = _mm512_srli_epi64(v[3], 16);
+        for (i = 0; i < FP_DIGS; i++)
+            v[i] = _mm512_loadu_si512((const void *)(BATCH_ROW(b, i, stride) + j0));
+        y[0] = _mm512_and_si512(v[0], mask52);
+        y[1] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[0], 52), _mm512_slli_epi64(v[1], 12)), mask52);
+        y[2] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[1], 40), _mm512_slli_epi64(v[2], 24)), mask52);
+        y[3] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(v[2], 28), _mm512_slli_epi64(v[3], 36)), mask52);
+        y[4] = _mm512_srli_epi64(v[3], 16);
+
+        // t = x * y，各分量累加的乘积不超过10个，不会溢出64位
+        for (k = 0; k < 10; k++)
+            t[k] = zero;
+        for (i = 0; i < 5; i++)
+            for (k = 0; k < 5; k++) {
+                t[i + k] = _mm512_madd52lo_epu64(t[i + k], x[i], y[k]);
+                t[i + k + 1] = _mm512_madd52hi_epu64(t[i + k + 1], x[i], y[k]);
+            }
+
+        // 消去低208位
+        for (i = 0; i < 4; i++) {
+            u = _mm512_and_si512(_mm512_madd52lo_epu64(zero, t[i], n0), mask52);
+            for (k = 0; k < 5; k++) {
+                t[i + k] = _mm512_madd52lo_epu64(t[i + k], u, m[k]);
+                t[i + k + 1] = _mm512_madd52hi_epu64(t[i + k + 1], u, m[k]);
+            }
+            t[i + 1] = _mm512_add_epi64(t[i + 1], _mm512_srli_epi64(t[i], 52));
+        }
+        // 再消去48位，共256位
+        u = _mm512_and_si512(_mm512_madd52lo_epu64(zero, t[4], n0), mask48);
+        for (k = 0; k < 5; k++) {
+            t[4 + k] = _mm512_madd52lo_epu64(t[4 + k], u, m[k]);
+            t[5 + k] = _mm512_madd52hi_epu64(t[5 + k], u, m[k]);
+        }
+        for (k = 4; k < 9; k++) {
+            t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+            t[k] = _mm512_and_si512(t[k], mask52);
+        }
+
+        // r = t / 2^256
+        for (k = 0; k < 5; k++)
+            r[k] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(t[4 + k], 48), _mm512_slli_epi64(t[5 + k], 4)),
+                                    mask52);
+
+        // d = r - m，不借位时取d
+        borrow = zero;
+        for (k = 0; k < 5; k++) {
+            d[k] = _mm512_sub_epi64(_mm512_sub_epi64(r[k], m[k]), borrow);
+            borrow = _mm512_srli_epi64(d[k], 63);
+            d[k] = _mm512_and_si512(d[k], mask52);
+        }
+        __mmask8 keep = _mm512_cmpeq_epi64_mask(borrow, zero);
+        for (k = 0; k < 5; k++)
+            r[k] = _mm512_mask_mov_epi64(r[k], keep, d[k]);
+
+        // 52位分量 -> 64位分量
+        v[0] = _mm512_or_si512(r[0], _mm512_slli_epi64(r[1], 52));
+        v[1] = _mm512_or_si512(_mm512_srli_epi64(r[1], 12), _mm512_slli_epi64(r[2], 40));
+        v[2] = _mm512_or_si512(_mm512_srli_epi64(r[2], 24), _mm512_slli_epi64(r[3], 28));
+        v[3] = _mm512_or_si512(_mm512_srli_epi64(r[3], 36), _mm512_slli_epi64(r[4], 16));
+        for (i = 0; i < FP_DIGS; i++)
+            _mm512_storeu_si512((void *)(BATCH_ROW(c, i, stride) + j0), v[i]);
+    }
+}
+
+#define FP29_MASK ((1ULL << 29) - 1)
+
+/* 移位位数不是立即数时使用的逐通道移位（-O0下立即数版本无法编译） */
+#define SRL4(x, s) _mm256_srl_epi64(x, _mm_cvtsi32_si128(s))
+#define SLL4(x, s) _mm256_sll_epi64(x, _mm_cvtsi32_si128(s))
+
+/* 4通道，9×29位分量，使用32×32位乘法vpmuludq */
+__attribute__((target("avx2"))) static void fp_vec_mul_avx2(uint64_t *c, const uint64_t *a, const uint64_t *b,
+                                                            size_t n, size_t stride, const fp_ctx *ctx) {
+    const __m256i mask29 = _mm256_set1_epi64x(FP29_MASK);
+    const __m256i mask24 = _mm256_set1_epi64x((1LL << 24) - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i n0 = _mm256_set1_epi64x(ctx->n0 & FP29_MASK);
+    __m256i m[9];
+    int i, k;
+
+    // 模数的29位分量
+    for (k = 0; k < 9; k++) {
+        int pos = 29 * k, w = pos / 64, off = pos % 64;
+        uint64_t limb = ctx->m[w] >> off;
+        if (off > 64 - 29 && w + 1 < FP_DIGS)
+            limb |= ctx->m[w + 1] << (64 - off);
+        m[k] = _mm256_set1_epi64x(limb & FP29_MASK);
+    }
+
+    for (size_t j0 = 0; j0 < n; j0 += 4) {
+        __m256i va[FP_DIGS], vb[FP_DIGS], x[9], y[9], t[18], r[9], u, borrow, keep;
+
+        for (i = 0; i < FP_DIGS; i++) {
+            va[i] = _mm256_loadu_si256((const __m256i *)(BATCH_ROW(a, i, stride) + j0));
+            vb[i] = _mm256_loadu_si256((const __m256i *)(BATCH_ROW(b, i, stride) + j0));
+        }
+        // 64位分量 -> 29位分量
+        for (k = 0; k < 9; k++) {
+            int pos = 29 * k, w = pos / 64, off = pos % 64;
+            x[k] = SRL4(va[w], off);
+            y[k] = SRL4(vb[w], off);
+            if (off > 64 - 29 && w + 1 < FP_DIGS) {
+                x[k] = _mm256_or_si256(x[k], SLL4(va[w + 1], 64 - off));
+                y[k] = _mm256_or_si256(y[k], SLL4(vb[w + 1], 64 - off));
+            }
+            x[k] = _mm256_and_si256(x[k], mask29);
+            y[k] = _mm256_and_si256(y[k], mask29);
+        }
+
+        // t = x * y，乘积小于2^58，累加后仍在64位以内
+        for (k = 0; k < 18; k++)
+            t[k] = zero;
+        for (i = 0; i < 9; i++)
+            for (k = 0; k < 9; k++)
+                t[i + k] = _mm256_add_epi64(t[i + k], _mm256_mul_epu32(x[i], y[k]));
+
+        // 消去低232位
+        for (i = 0; i < 8; i++) {
+            u = _mm256_and_si256(_mm256_mul_epu32(t[i], n0), mask29);
+            for (k = 0; k < 9; k++)
+                t[i + k] = _mm256_add_epi64(t[i + k], _mm256_mul_epu32(u, m[k]));
+            t[i + 1] = _mm256_add_epi64(t[i + 1], _mm256_srli_epi64(t[i], 29));
+        }
+        // 再消去24位，共256位
+        u = _mm256_and_si256(_mm256_mul_epu32(t[8], n0), mask24);
+        for (k = 0; k < 9; k++)
+            t[8 + k] = _mm256_add_epi64(t[8 + k], _mm256_mul_epu32(u, m[k]));
+        for (k = 8; k < 17; k++) {
+            t[k + 1] = _mm256_add_epi64(t[k + 1], _mm256_srli_epi64(t[k], 29));
+            t[k] = _mm256_and_si256(t[k], mask29);
+        }
+
+        // r = t / 2^256
+        for (k = 0; k < 9; k++)
+            r[k] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(t[8 + k], 24), _mm256_slli_epi64(t[9 + k], 5)),
+                                    mask29);
+
+        // d = r - m，不借位时取d（d暂存于x）
+        borrow = zero;
+        for (k = 0; k < 9; k++) {
+            x[k] = _mm256_sub_epi64(_mm256_sub_epi64(r[k], m[k]), borrow);
+            borrow = _mm256_srli_epi64(x[k], 63);
+            x[k] = _mm256_and_si256(x[k], mask29);
+        }
+        keep = _mm256_cmpeq_epi64(borrow, zero);
+        for (k = 0; k < 9; k++)
+            r[k] = _mm256_blendv_epi8(r[k], x[k], keep);
+
+        // 29位分量 -> 64位分量
+        for (i = 0; i < FP_DIGS; i++)
+            va[i] = zero;
+        for (k = 0; k < 9; k++) {
+            int pos = 29 * k, w = pos / 64, off = pos % 64;
+            va[w] = _mm256_or_si256(va[w], SLL4(r[k], off));
+            if (off > 64 - 29 && w + 1 < FP_DIGS)
+                va[w + 1] = _mm256_or_si256(va[w + 1], SRL4(r[k], 64 - off));
+        }
+        for (i = 0; i < FP_DIGS; i++)
+            _mm256_storeu_si256((__m256i *)(BATCH_ROW(c, i, stride) + j0), va[i]);
+    }
+}
+
+#endif
+
+void fp_vec_mul(uint64_t *c, const uint64_t *a, const uint64_t *b, size_t n, size_t stride, const fp_ctx *ctx) {
+#ifdef BATCH_X86
+    unsigned int features = cpu_features();
+
+    if ((features & (CPU_AVX512F | CPU_AVX512IFMA)) == (CPU_AVX512F | CPU_AVX512IFMA)) {
+        INSTR_ADD(INSTR_MOD_MUL, n);
+        fp_vec_mul_ifma(c, a, b, n, stride, ctx);
+        return;
+    }
+    if (features & CPU_AVX2) {
+        INSTR_ADD(INSTR_MOD_MUL, n);
+        fp_vec_mul_avx2(c, a, b, n, stride, ctx);
+        return;
+    }
+#endif
+    fp_vec_mul_c(c, a, b, n, stride, ctx);
+}
+
+void fp_vec_select(uint64_t *c, const uint64_t *a, const uint64_t *b, const uint8_t *sel, size_t n, size_t stride) {
+    for (int i = 0; i < FP_DIGS; i++) {
+        const uint64_t *ra = BATCH_ROW(a, i, stride), *rb = BATCH_ROW(b, i, stride);
+        uint64_t *rc = BATCH_ROW(c, i, stride);
+        for (size_t j = 0; j < n; j++) {
+            uint64_t mask = 0 - (uint64_t)(sel[j] & 1);
+            rc[j] = (ra[j] & ~mask) | (rb[j] & mask);
+        }
+    }
+}
+
+void fp_vec_inv(uint64_t *c, const uint64_t *a, size_t n, size_t stride, const fp_ctx *ctx, arena *ar) {
+    size_t mark;
+    fp_t *pre, acc, t, x;
+    size_t j;
+
+    if (n == 0)
+        return;
+
+    // pre[j] = a[0] * ... * a[j]（跳过0）
+    mark = arena_mark(ar);
+    pre = (fp_t *)arena_alloc(ar, n * sizeof(fp_t));
+    fp_copy(acc, ctx->one);
+    for (j = 0; j < n; j++) {
+        fp_vec_get(x, a, stride, j);
+        if (!fp_is_zero(x))
+            fp_mul(acc, acc, x, ctx);
+        fp_copy(pre[j], acc);
+    }
+
+    // acc = 1 / pre[n - 1]，再自后向前剥离
+    fp_inv(acc, acc, ctx);
+    for (j = n; j-- > 0;) {
+        fp_vec_get(x, a, stride, j);
+        if (fp_is_zero(x)) {
+            fp_vec_set(c, stride, j, x);
+            continue;
+        }
+        if (j > 0)
+            fp_mul(t, acc, pre[j - 1], ctx);
+        else
+            fp_copy(t, acc);
+        fp_mul(acc, acc, x, ctx);
+        fp_vec_set(c, stride, j, t);
+    }
+    arena_release(ar, mark);
+}
@@ -1,9 +1,12 @@
 #include "bn.h"
+#include "instr.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 /* utils */
 void bn_make(bn_t a, size_t digits) {
@@ -16,6 +19,7 @@ void bn_make(bn_t a, size_t digits) {
         a->alloc = digits;
         a->sign = BN_POS;
         memset(a->dp, 0, digits * sizeof(dig_t));
+        INSTR_COUNT(INSTR_BN_NEW);
     }
 }
 
@@ -32,23 +36,39 @@ void bn_trim(bn_t a) {
     }
 }
 
-void bn_rand(bn_t a, int sign, size_t bits) {
+void bn_rand_bytes(uint8_t *buf, size_t len) {
+#ifdef _WIN32
     HCRYPTPROV ctx;
     if (!CryptAcquireContext(&ctx, NULL, NULL, PROV_RSA_FULL, 0))
         abort();
 
-    size_t word_size = (bits + WSIZE - 1) / WSIZE;
-    size_t buffer_size = word_size * (WSIZE / 8);
-    BYTE *buffer = (BYTE *)malloc(buffer_size);
-    if (buffer == NULL)
+    if (!CryptGenRandom(ctx, len, buf))
+        abort();
+
+    if (!CryptReleaseContext(ctx, 0))
+        abort();
+#else
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if (fp == NULL)
         abort();
 
-    if (!CryptGenRandom(ctx, buffer_size, buffer))
+    if (fread(buf, 1, len, fp) != len)
         abort();
 
-    if (!CryptReleaseContext(ctx, 0))
+    fclose(fp);
+#endif
+}
+
+void bn_rand(bn_t a, int sign, size_t bits) {
+    size_t word_size = (bits + WSIZE - 1) / WSIZE;
+    size_t buffer_size = word_size * (WSIZE / 8);
+    uint8_t buffer[BN_SIZE * (WSIZE / 8)];
+
+    if (word_size > BN_SIZE)
         abort();
 
+    bn_rand_bytes(buffer, buffer_size);
+
     for (size_t i = 0; i < word_size; i++) {
         a->dp[i] = 0;
         for (size_t j = 0; j < WSIZE / 8; j++)
@@ -63,17 +83,19 @@ void bn_rand(bn_t a, int sign, size_t bits) {
     a->used = word_size;
     a->sign = sign;
     bn_trim(a);
-    free(buffer);
 }
 
 void bn_rand_mod(bn_t a, const bn_st *m) {
-    bn_t t;
-    bn_new(t);
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
+
     bn_copy(t, m);
     do {
         bn_rand(a, m->sign, bn_bit_len(t) + RAND_DIST);
         bn_mod(a, a, t);
     } while (bn_is_zero(a) || bn_cmp_abs(a, t) != BN_LT);
+    arena_release(ar, mark);
 }
 
 int dv_cmp(const dig_t *a, const dig_t *b, size_t size) {
@@ -183,6 +205,8 @@ int bn_bit_len(const bn_t a) {
 int bn_get_one_bit(const bn_t a, int bit) {
     int bit_index = bit % WSIZE;
     int word_index = bit / WSIZE;
+    if (word_index >= (int)a->used)
+        return 0;
     return (a->dp[word_index] >> bit_index) & 1;
 }
 
@@ -195,12 +219,10 @@ int bn_is_zero(const bn_t a) {
 void bn_zero(bn_t a) {
     a->used = 1;
     a->sign = BN_POS;
-    for (int i = 0; i < a->alloc; i++)
-        a->dp[i] = 0;
+    a->dp[0] = 0;
 }
 
 void bn_set_dig(bn_t a, dig_t digit) {
-    bn_zero(a);
     a->dp[0] = digit;
     a->used = 1;
     a->sign = BN_POS;
@@ -232,17 +254,7 @@ void bn_neg(bn_t c, const bn_t a) {
 }
 
 void bn_from_digest(bn_t a, const uint8_t digest[SM3_DIGEST_SIZE]) {
-    for (int i = 0; i < SM3_DIGEST_SIZE; i += 8) {
-        a->dp[3 - i / 8] |= (dig_t)digest[i] << 56;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 1] << 48;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 2] << 40;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 3] << 32;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 4] << 24;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 5] << 16;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 6] << 8;
-        a->dp[3 - i / 8] |= (dig_t)digest[i + 7];
-    }
-    a->used = 4;
+    bn_from_bytes(a, digest, SM3_DIGEST_SIZE);
 }
 
 void bn_from_hex(bn_t a, const char *hex) {
@@ -292,17 +304,48 @@ void bn_from_hex(bn_t a, const char *hex) {
     bn_trim(a);
 }
 
-char *bn_to_hex(const bn_t a) {
-    if (bn_is_zero(a))
-        return "0";
+size_t bn_to_hex(char *hex, size_t len, const bn_t a) {
+    static const char digits[] = "0123456789ABCDEF";
+    size_t n = 0, need;
+    int bits = bn_bit_len(a);
+
+    need = (bits > 0 ? (bits + 3) / 4 : 1) + (a->sign == BN_NEG && !bn_is_zero(a)) + 1;
+    if (hex == NULL || len < need)
+        return 0;
+
+    if (a->sign == BN_NEG && !bn_is_zero(a))
+        hex[n++] = '-';
+    if (bits == 0)
+        hex[n++] = '0';
+    for (int i = (bits + 3) / 4 - 1; i >= 0; i--)
+        hex[n++] = digits[(a->dp[i / 16] >> (4 * (i % 16))) & 0xF];
+    hex[n] = '\0';
+    return n;
+}
 
-    char *hex = malloc((a->used * WSIZE / 8 + 1) * sizeof(char));
-    int j = 0;
-    for (int i = a->used - 1; i >= 0; i--)
-        for (int shift = WSIZE - 8; shift >= 0; shift -= 8)
-            hex[j++] = (a->dp[i] >> shift) & 0xFF;
-    hex[j] = '\0';
-    return hex;
+void bn_from_bytes(bn_t a, const uint8_t *bin, size_t len) {
+    size_t i, digits;
+
+    if (len > BN_SIZE * sizeof(dig_t))
+        len = BN_SIZE * sizeof(dig_t);
+    digits = (len + sizeof(dig_t) - 1) / sizeof(dig_t);
+
+    a->alloc = BN_SIZE;
+    a->sign = BN_POS;
+    a->dp[0] = 0;
+    for (i = 1; i < digits; i++)
+        a->dp[i] = 0;
+    for (i = 0; i < len; i++)
+        a->dp[i / sizeof(dig_t)] |= (dig_t)bin[len - 1 - i] << (8 * (i % sizeof(dig_t)));
+    a->used = digits > 0 ? digits : 1;
+    bn_trim(a);
+}
+
+void bn_to_bytes(uint8_t *bin, size_t len, const bn_t a) {
+    for (size_t i = 0; i < len; i++) {
+        size_t d = i / sizeof(dig_t);
+        bin[len - 1 - i] = d < a->used ? (uint8_t)(a->dp[d] >> (8 * (i % sizeof(dig_t)))) : 0;
+    }
 }
 
 void bn_print(bn_t a) {
@@ -481,6 +524,41 @@ void bn_muln_low(dig_t *c, const dig_t *a, const dig_t *b, size_t size) {
     }
 }
 
+void bn_sqrn_low(dig_t *c, const dig_t *a, size_t size) {
+    size_t i, j, k;
+    dig_t r0, r1, r2, t0, t1, t2, carry;
+
+    r0 = r1 = r2 = 0;
+    for (k = 0; k < 2 * size - 1; k++, c++) {
+        /* each a[i] * a[j] with i < j appears twice in column k = i + j: sum once, then double */
+        t0 = t1 = t2 = 0;
+        i = k < size ? 0 : k - size + 1;
+        for (j = k - i; i < j; i++, j--) {
+            COMBA_STEP_MUL(t2, t1, t0, a[i], a[j]);
+        }
+        t2 = (t2 << 1) | (t1 >> (DIG - 1));
+        t1 = (t1 << 1) | (t0 >> (DIG - 1));
+        t0 <<= 1;
+        if (i == j) {
+            COMBA_STEP_MUL(t2, t1, t0, a[i], a[i]);
+        }
+
+        r0 += t0;
+        carry = r0 < t0;
+        r1 += carry;
+        carry = r1 < carry;
+        r1 += t1;
+        carry += r1 < t1;
+        r2 += t2 + carry;
+
+        *c = r0;
+        r0 = r1;
+        r1 = r2;
+        r2 = 0;
+    }
+    *c = r0;
+}
+
 void bn_muld_low(dig_t *c, const dig_t *a, size_t sa, const dig_t *b, size_t sb, uint_t l, uint_t h) {
     int i, j, ta;
     const dig_t *tmpa, *tmpb;
@@ -652,7 +730,9 @@ void bn_divn_low(dig_t *c, dig_t *d, dig_t *a, size_t sa, dig_t *b, size_t sb) {
 }
 
 void bn_div_imp(bn_t c, bn_t d, const bn_t a, const bn_t b) {
-    bn_t q, x, y, r;
+    arena *ar;
+    size_t mark;
+    bn_st *q, *x, *y, *r;
     int sign;
 
     /* If |a| < |b|, we're done. */
@@ -676,14 +756,15 @@ void bn_div_imp(bn_t c, bn_t d, const bn_t a, const bn_t b) {
         return;
     }
 
-    /* Be conservative about space for scratch memory, many attempts to
-     * optimize these had invalid reads. */
-    bn_new_size(x, a->used + 1);
-    bn_new_size(q, a->used + 1);
-    bn_new_size(y, a->used + 1);
-    bn_new_size(r, a->used + 1);
-    bn_zero(q);
-    bn_zero(r);
+    /* Scratch comes from the thread arena uncleared; the quotient digits are
+     * accumulated in place (c[n - t]++), so clear those explicitly. */
+    ar = arena_thread();
+    mark = arena_mark(ar);
+    x = bn_tmp(ar);
+    q = bn_tmp(ar);
+    y = bn_tmp(ar);
+    r = bn_tmp(ar);
+    memset(q->dp, 0, (a->used + 2) * sizeof(dig_t));
     bn_abs(x, a);
     bn_abs(y, b);
 
@@ -716,10 +797,13 @@ void bn_div_imp(bn_t c, bn_t d, const bn_t a, const bn_t b) {
             bn_sub(d, b, r);
         }
     }
+    arena_release(ar, mark);
 }
 
 void bn_gcd_ext(bn_t c, bn_t d, bn_t e, const bn_t a, const bn_t b) {
-    bn_t u, v, x_1, y_1, q, r;
+    arena *ar;
+    size_t mark;
+    bn_st *u, *v, *x_1, *y_1, *q, *r;
 
     if (bn_is_zero(a)) {
         bn_abs(c, b);
@@ -737,12 +821,14 @@ void bn_gcd_ext(bn_t c, bn_t d, bn_t e, const bn_t a, const bn_t b) {
         return;
     }
 
-    bn_new(u);
-    bn_new(v);
-    bn_new(x_1);
-    bn_new(y_1);
-    bn_new(q);
-    bn_new(r);
+    ar = arena_thread();
+    mark = arena_mark(ar);
+    u = bn_tmp(ar);
+    v = bn_tmp(ar);
+    x_1 = bn_tmp(ar);
+    y_1 = bn_tmp(ar);
+    q = bn_tmp(ar);
+    r = bn_tmp(ar);
 
     bn_abs(u, a);
     bn_abs(v, b);
@@ -772,6 +858,7 @@ void bn_gcd_ext(bn_t c, bn_t d, bn_t e, const bn_t a, const bn_t b) {
         }
     }
     bn_copy(c, u);
+    arena_release(ar, mark);
 }
 
 /* operation functions */
@@ -859,10 +946,10 @@ void bn_sub(bn_t c, const bn_t a, const bn_t b) {
 }
 
 void bn_mul(bn_t c, const bn_t a, const bn_t b) {
-    bn_t t;
-    bn_new(t);
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
 
-    bn_new_size(t, a->used + b->used);
     t->used = a->used + b->used;
     if (a->used == b->used) {
         bn_muln_low(t->dp, a->dp, b->dp, a->used);
@@ -877,11 +964,26 @@ void bn_mul(bn_t c, const bn_t a, const bn_t b) {
     t->sign = a->sign ^ b->sign;
     bn_trim(t);
     bn_copy(c, t);
+    arena_release(ar, mark);
+}
+
+void bn_sqr(bn_t c, const bn_t a) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
+
+    t->used = 2 * a->used;
+    bn_sqrn_low(t->dp, a->dp, a->used);
+    t->sign = BN_POS;
+    bn_trim(t);
+    bn_copy(c, t);
+    arena_release(ar, mark);
 }
 
 void bn_div(bn_t c, bn_t d, const bn_t a, const bn_t b) {
     if (bn_is_zero(b))
         return;
+    INSTR_COUNT(INSTR_BN_DIV);
     bn_div_imp(c, d, a, b);
 }
 
@@ -890,10 +992,11 @@ void bn_mod(bn_t c, const bn_t a, const bn_t m) {
 }
 
 void bn_mod_inv(bn_t c, const bn_t a, const bn_t b) {
-    bn_t t, u;
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar), *u = bn_tmp(ar);
 
-    bn_new(t);
-    bn_new(u);
+    INSTR_COUNT(INSTR_MOD_INV);
 
     bn_mod(t, a, b);
     bn_copy(u, b);
@@ -901,24 +1004,157 @@ void bn_mod_inv(bn_t c, const bn_t a, const bn_t b) {
 
     if (c->sign == BN_NEG)
         bn_add(c, c, u);
+    arena_release(ar, mark);
+}
 
-    if (bn_cmp_dig(t, 1) != BN_EQ)
-        return;
+/* t[0..n) = a zero-extended to n digits (a->used <= n) */
+static void bn_pad(dig_t *t, const bn_t a, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        t[i] = i < a->used ? a->dp[i] : 0;
+}
+
+/* 0 <= a < m */
+static int bn_is_reduced(const bn_t a, const bn_t m) {
+    return a->sign == BN_POS && bn_cmp(a, m) == BN_LT;
+}
+
+/* c = s - m if (hi, s[0..n)) >= m, else s; hi <= 1, one masked subtraction */
+static void bn_mod_fix(bn_t c, const dig_t *s, dig_t hi, const bn_t m) {
+    dig_t d[BN_SIZE], borrow, mask;
+    size_t n = m->used;
+
+    borrow = bn_subn_low(d, s, m->dp, n);
+    /* keep s only when the subtraction borrowed out of hi */
+    mask = 0 - (dig_t)(borrow > hi);
+    for (size_t i = 0; i < n; i++)
+        c->dp[i] = (s[i] & mask) | (d[i] & ~mask);
+    c->used = n;
+    c->sign = BN_POS;
+    bn_trim(c);
 }
 
 void bn_mod_add(bn_t c, const bn_t a, const bn_t b, const bn_t m) {
-    bn_add(c, a, b);
-    if (bn_cmp(c, m) == BN_GT)
+    dig_t s[BN_SIZE], t[BN_SIZE], carry;
+    size_t n = m->used;
+
+    if (!bn_is_reduced(a, m) || !bn_is_reduced(b, m)) {
+        bn_add(c, a, b);
         bn_mod(c, c, m);
+        return;
+    }
+    bn_pad(s, a, n);
+    bn_pad(t, b, n);
+    carry = bn_addn_low(s, s, t, n);
+    bn_mod_fix(c, s, carry, m);
 }
 
 void bn_mod_sub(bn_t c, const bn_t a, const bn_t b, const bn_t m) {
-    bn_sub(c, a, b);
-    while (c->sign == BN_NEG)
-        bn_add(c, c, m);
+    dig_t s[BN_SIZE], t[BN_SIZE], mask;
+    size_t n = m->used;
+
+    if (!bn_is_reduced(a, m) || !bn_is_reduced(b, m)) {
+        bn_sub(c, a, b);
+        bn_mod(c, c, m);
+        return;
+    }
+    bn_pad(s, a, n);
+    bn_pad(t, b, n);
+    /* add m back if a < b */
+    mask = 0 - bn_subn_low(s, s, t, n);
+    for (size_t i = 0; i < n; i++)
+        t[i] = m->dp[i] & mask;
+    bn_addn_low(c->dp, s, t, n);
+    c->used = n;
+    c->sign = BN_POS;
+    bn_trim(c);
+}
+
+void bn_mod_dbl(bn_t c, const bn_t a, const bn_t m) {
+    bn_mod_add(c, a, a, m);
+}
+
+void bn_mod_tpl(bn_t c, const bn_t a, const bn_t m) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar);
+
+    bn_mod_add(t, a, a, m);
+    bn_mod_add(c, t, a, m);
+    arena_release(ar, mark);
 }
 
 void bn_mod_mul(bn_t c, const bn_t a, const bn_t b, const bn_t m) {
+    if (a == b) {
+        bn_mod_sqr(c, a, m);
+        return;
+    }
+    INSTR_COUNT(INSTR_MOD_MUL);
     bn_mul(c, a, b);
     bn_mod(c, c, m);
 }
+
+void bn_mod_sqr(bn_t c, const bn_t a, const bn_t m) {
+    INSTR_COUNT(INSTR_MOD_SQR);
+    bn_sqr(c, a);
+    bn_mod(c, c, m);
+}
+
+void bn_mod_exp(bn_t c, const bn_t a, const bn_t e, const bn_t m) {
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t[16], *r;
+    int i, j, w;
+
+    /* t[i] = a^i mod m */
+    for (i = 0; i < 16; i++)
+        t[i] = bn_tmp(ar);
+    bn_set_dig(t[0], 1);
+    bn_mod(t[1], a, m);
+    for (i = 2; i < 16; i++)
+        bn_mod_mul(t[i], t[i - 1], t[1], m);
+
+    r = bn_tmp(ar);
+    bn_set_dig(r, 1);
+    for (i = (bn_bit_len(e) + 3) / 4 - 1; i >= 0; i--) {
+        for (j = 0; j < 4; j++)
+            bn_mod_sqr(r, r, m);
+        w = 0;
+        for (j = 3; j >= 0; j--)
+            w = (w << 1) | (4 * i + j < (int)(e->used * WSIZE) ? bn_get_one_bit(e, 4 * i + j) : 0);
+        if (w != 0)
+            bn_mod_mul(r, r, t[w], m);
+    }
+    bn_copy(c, r);
+    arena_release(ar, mark);
+}
+
+int bn_mod_sqrt(bn_t c, const bn_t a, const bn_t p) {
+    arena *ar;
+    size_t mark;
+    bn_st *e, *r, *t;
+    int ok;
+
+    if ((p->dp[0] & 3) != 3)
+        return 0;
+
+    /* e = (p + 1) / 4 */
+    ar = arena_thread();
+    mark = arena_mark(ar);
+    e = bn_tmp(ar);
+    r = bn_tmp(ar);
+    t = bn_tmp(ar);
+    bn_add_dig(e, p, 1);
+    bn_rshb_low(e->dp, e->dp, e->used, 2);
+    bn_trim(e);
+
+    bn_mod_exp(r, a, e, p);
+
+    /* a is a square iff r^2 = a */
+    bn_mod_sqr(t, r, p);
+    bn_mod(e, a, p);
+    ok = bn_cmp(t, e) == BN_EQ;
+    if (ok)
+        bn_copy(c, r);
+    arena_release(ar, mark);
+    return ok;
+}
@@ -0,0 +1,74 @@
+#include "cpu.h"
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+static uint64_t cpu_xgetbv(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static unsigned int cpu_detect(void) {
+    unsigned int eax, ebx, ecx, edx, ecx1, features = 0;
+    uint64_t xcr0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx1, &edx))
+        return 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    /* 标量扩展不依赖操作系统保存的寄存器状态 */
+    if (ebx & bit_BMI2)
+        features |= CPU_BMI2;
+    if (ebx & bit_ADX)
+        features |= CPU_ADX;
+
+    /* 需要OSXSAVE与AVX，且操作系统保存了YMM状态 */
+    if (!(ecx1 & bit_OSXSAVE) || !(ecx1 & bit_AVX))
+        return features;
+    xcr0 = cpu_xgetbv();
+    if ((xcr0 & 0x06) != 0x06)
+        return features;
+
+    if (ebx & bit_AVX2)
+        features |= CPU_AVX2;
+
+    /* AVX-512还需要操作系统保存opmask与ZMM状态 */
+    if ((xcr0 & 0xE0) == 0xE0) {
+        if (ebx & bit_AVX512F)
+            features |= CPU_AVX512F;
+        if (ebx & bit_AVX512BW)
+            features |= CPU_AVX512BW;
+        if (ebx & bit_AVX512IFMA)
+            features |= CPU_AVX512IFMA;
+    }
+
+    return features;
+}
+#else
+static unsigned int cpu_detect(void) {
+    return 0;
+}
+#endif
+
+#define CPU_DETECTED (1u << 31) /* 已完成检测 */
+
+static unsigned int cpu_flags = 0;
+static unsigned int cpu_masked = 0;
+
+unsigned int cpu_features(void) {
+    unsigned int flags = cpu_flags;
+
+    /* 检测结果是确定的，并发首次调用只会写入相同的值 */
+    if (!(flags & CPU_DETECTED)) {
+        flags = cpu_detect() | CPU_DETECTED;
+        cpu_flags = flags;
+    }
+    return flags & ~cpu_masked & ~CPU_DETECTED;
+}
+
+void cpu_disable(unsigned int features) {
+    cpu_masked |= features;
+}
@@ -1,8 +1,13 @@
 #include "ec.h"
 #include "bn.h"
 
+#define EC_SCALAR_SIZE 32 /* 256位曲线参数的字节数 */
+
 void create_group(group *g, const char *p_hex, const char *a_hex, const char *b_hex, const char *gx_hex,
                   const char *gy_hex, const char *n_hex) {
+    uint8_t buf[4 * EC_SCALAR_SIZE];
+    bn_t t;
+
     bn_new(g->p);
     bn_new(g->a);
     bn_new(g->b);
@@ -14,4 +19,18 @@ void create_group(group *g, const char *p_hex, const char *a_hex, const char *b_
     bn_from_hex(g->n, n_hex);
     bn_from_hex(g->g.x, gx_hex);
     bn_from_hex(g->g.y, gy_hex);
+    fp_ctx_init(&g->fn, g->n);
+
+    fp_ctx_init(&g->fp, g->p);
+    fp_from_bn(g->ma, g->a, &g->fp);
+    bn_new(t);
+    bn_add_dig(t, g->a, 3);
+    g->a_m3 = bn_cmp(t, g->p) == BN_EQ;
+
+    // Z只依赖a、b与G，以它们的摘要区分曲线
+    bn_to_bytes(buf, EC_SCALAR_SIZE, g->a);
+    bn_to_bytes(buf + EC_SCALAR_SIZE, EC_SCALAR_SIZE, g->b);
+    bn_to_bytes(buf + 2 * EC_SCALAR_SIZE, EC_SCALAR_SIZE, g->g.x);
+    bn_to_bytes(buf + 3 * EC_SCALAR_SIZE, EC_SCALAR_SIZE, g->g.y);
+    SM3(buf, sizeof(buf), g->tag);
 }
@@ -0,0 +1,653 @@
+#include "ecp.h"
+#include "instr.h"
+
+/* 常数时间路径：255 / W个带符号奇数字加一个最高位数字 */
+#define ECP_CT_DIGS ((FP_DIGS * 64 - 1) / ECP_W)
+
+/* 变时路径的wNAF表长（奇数倍1, 3, ..., 2^(W-1) - 1） */
+#define ECP_NAF_TBL  (1 << (ECP_W - 2))
+#define ECP_NAF_DIGS (FP_DIGS * 64 + 1)
+
+/* c = mask ? a : c，mask为全0或全1 */
+static void fp_cmov(fp_t c, const fp_t a, uint64_t mask) {
+    for (int i = 0; i < FP_DIGS; i++)
+        c[i] = (c[i] & ~mask) | (a[i] & mask);
+}
+
+static void ecp_cmov(ecp *r, const ecp *a, uint64_t mask) {
+    fp_cmov(r->x, a->x, mask);
+    fp_cmov(r->y, a->y, mask);
+    fp_cmov(r->z, a->z, mask);
+}
+
+/* r = -a */
+static void ecp_neg(ecp *r, const ecp *a, const group *g) {
+    const fp_t zero = {0};
+
+    fp_copy(r->x, a->x);
+    fp_sub(r->y, zero, a->y, &g->fp);
+    fp_copy(r->z, a->z);
+}
+
+/* r = 无穷远点(1, 1, 0) */
+static void ecp_set_infty(ecp *r, const group *g) {
+    fp_copy(r->x, g->fp.one);
+    fp_copy(r->y, g->fp.one);
+    for (int i = 0; i < FP_DIGS; i++)
+        r->z[i] = 0;
+}
+
+void ecp_set_point(ecp *r, const point *a, const group *g) {
+    if (point_is_infty(a)) {
+        ecp_set_infty(r, g);
+        return;
+    }
+    fp_from_bn(r->x, a->x, &g->fp);
+    fp_from_bn(r->y, a->y, &g->fp);
+    fp_copy(r->z, g->fp.one);
+}
+
+int ecp_set_x(ecp *r, const bn_t x, int y_odd, const group *g) {
+    const fp_ctx *f = &g->fp;
+    const fp_t zero = {0};
+    fp_t t, b;
+    bn_t y;
+
+    if (x->sign == BN_NEG || bn_cmp(x, g->p) != BN_LT)
+        return 0;
+    // t = (x^2 + a)x + b
+    fp_from_bn(r->x, x, f);
+    fp_from_bn(b, g->b, f);
+    fp_sqr(t, r->x, f);
+    fp_add(t, t, g->ma, f);
+    fp_mul(t, t, r->x, f);
+    fp_add(t, t, b, f);
+    if (!fp_sqrt(r->y, t, f))
+        return 0;
+    // 选取奇偶性匹配的根，y = 0时不存在奇数根
+    fp_to_bn(y, r->y, f);
+    if ((int)(y->dp[0] & 1) != (y_odd & 1)) {
+        if (fp_is_zero(r->y))
+            return 0;
+        fp_sub(r->y, zero, r->y, f);
+    }
+    fp_copy(r->z, f->one);
+    return 1;
+}
+
+void ecp_get_point(point *r, const ecp *a, const group *g) {
+    fp_t zi, zi2, t;
+
+    if (ecp_is_infty(a)) {
+        point_new(r);
+        return;
+    }
+    fp_inv(zi, a->z, &g->fp);
+    fp_sqr(zi2, zi, &g->fp);
+    fp_mul(t, a->x, zi2, &g->fp);
+    fp_to_bn(r->x, t, &g->fp);
+    fp_mul(zi2, zi2, zi, &g->fp);
+    fp_mul(t, a->y, zi2, &g->fp);
+    fp_to_bn(r->y, t, &g->fp);
+}
+
+int ecp_x_equals(const ecp *a, const bn_t x, const group *g) {
+    fp_t t, zz;
+
+    if (ecp_is_infty(a))
+        return 0;
+    fp_from_bn(t, x, &g->fp);
+    fp_sqr(zz, a->z, &g->fp);
+    fp_mul(t, t, zz, &g->fp);
+    return fp_equal(t, a->x);
+}
+
+void ecp_dbl(ecp *r, const ecp *a, const group *g) {
+    const fp_ctx *f = &g->fp;
+    fp_t t0, t1, t2, t3, m, x3, y3, z3;
+
+    INSTR_COUNT(INSTR_POINT_DBL);
+    // Z = 0时Z3 = 2YZ = 0，结果仍为无穷远点；阶为奇素数的曲线上没有Y = 0的点
+    if (g->a_m3) {
+        // t0 = Z^2，t1 = Y^2，t2 = XY^2，m = 3(X - Z^2)(X + Z^2)
+        fp_sqr(t0, a->z, f);
+        fp_sqr(t1, a->y, f);
+        fp_mul(t2, a->x, t1, f);
+        fp_sub(t3, a->x, t0, f);
+        fp_add(m, a->x, t0, f);
+        fp_mul(m, m, t3, f);
+        fp_tpl(m, m, f);
+        // X3 = m^2 - 8XY^2
+        fp_dbl(t2, t2, f);
+        fp_dbl(t2, t2, f);
+        fp_sqr(x3, m, f);
+        fp_dbl(t3, t2, f);
+        fp_sub(x3, x3, t3, f);
+        // Z3 = (Y + Z)^2 - Y^2 - Z^2
+        fp_add(z3, a->y, a->z, f);
+        fp_sqr(z3, z3, f);
+        fp_sub(z3, z3, t1, f);
+        fp_sub(z3, z3, t0, f);
+        // Y3 = m(4XY^2 - X3) - 8Y^4
+        fp_sub(y3, t2, x3, f);
+        fp_mul(y3, y3, m, f);
+        fp_sqr(t1, t1, f);
+        fp_dbl(t1, t1, f);
+        fp_dbl(t1, t1, f);
+        fp_dbl(t1, t1, f);
+        fp_sub(y3, y3, t1, f);
+    } else {
+        // t0 = X^2，t1 = Y^2，t2 = Y^4，t3 = Z^2
+        fp_sqr(t0, a->x, f);
+        fp_sqr(t1, a->y, f);
+        fp_sqr(t2, t1, f);
+        fp_sqr(t3, a->z, f);
+        // s = 2((X + Y^2)^2 - X^2 - Y^4) = 4XY^2，放在y3中
+        fp_add(y3, a->x, t1, f);
+        fp_sqr(y3, y3, f);
+        fp_sub(y3, y3, t0, f);
+        fp_sub(y3, y3, t2, f);
+        fp_dbl(y3, y3, f);
+        // m = 3X^2 + aZ^4
+        fp_sqr(m, t3, f);
+        fp_mul(m, m, g->ma, f);
+        fp_tpl(t0, t0, f);
+        fp_add(m, m, t0, f);
+        // X3 = m^2 - 2s
+        fp_sqr(x3, m, f);
+        fp_dbl(t0, y3, f);
+        fp_sub(x3, x3, t0, f);
+        // Z3 = (Y + Z)^2 - Y^2 - Z^2
+        fp_add(z3, a->y, a->z, f);
+        fp_sqr(z3, z3, f);
+        fp_sub(z3, z3, t1, f);
+        fp_sub(z3, z3, t3, f);
+        // Y3 = m(s - X3) - 8Y^4
+        fp_sub(y3, y3, x3, f);
+        fp_mul(y3, y3, m, f);
+        fp_dbl(t2, t2, f);
+        fp_dbl(t2, t2, f);
+        fp_dbl(t2, t2, f);
+        fp_sub(y3, y3, t2, f);
+    }
+    fp_copy(r->x, x3);
+    fp_copy(r->y, y3);
+    fp_copy(r->z, z3);
+}
+
+/*
+ * r = a + b（12M + 4S），不含分支。a、b均不是无穷远点且a != ±b时结果正确；
+ * a = -b时H = 0，结果的Z为0（无穷远点）；返回值在a = b（H = 0且R = 0）时为全1，此时r无效
+ */
+static uint64_t ecp_add_raw(ecp *r, const ecp *a, const ecp *b, const group *g) {
+    const fp_ctx *f = &g->fp;
+    fp_t z1z1, z2z2, u1, u2, s1, s2, h, rr, hh, hhh, x3, y3, z3;
+
+    INSTR_COUNT(INSTR_POINT_ADD);
+    fp_sqr(z1z1, a->z, f);
+    fp_sqr(z2z2, b->z, f);
+    // U1 = X1 Z2^2，U2 = X2 Z1^2，S1 = Y1 Z2^3，S2 = Y2 Z1^3
+    fp_mul(u1, a->x, z2z2, f);
+    fp_mul(u2, b->x, z1z1, f);
+    fp_mul(s1, a->y, b->z, f);
+    fp_mul(s1, s1, z2z2, f);
+    fp_mul(s2, b->y, a->z, f);
+    fp_mul(s2, s2, z1z1, f);
+    // H = U2 - U1，R = S2 - S1
+    fp_sub(h, u2, u1, f);
+    fp_sub(rr, s2, s1, f);
+    // X3 = R^2 - H^3 - 2U1H^2
+    fp_sqr(hh, h, f);
+    fp_mul(hhh, hh, h, f);
+    fp_mul(u1, u1, hh, f);
+    fp_sqr(x3, rr, f);
+    fp_sub(x3, x3, hhh, f);
+    fp_dbl(u2, u1, f);
+    fp_sub(x3, x3, u2, f);
+    // Y3 = R(U1H^2 - X3) - S1H^3
+    fp_sub(y3, u1, x3, f);
+    fp_mul(y3, y3, rr, f);
+    fp_mul(s1, s1, hhh, f);
+    fp_sub(y3, y3, s1, f);
+    // Z3 = Z1 Z2 H
+    fp_mul(z3, a->z, b->z, f);
+    fp_mul(z3, z3, h, f);
+
+    fp_copy(r->x, x3);
+    fp_copy(r->y, y3);
+    fp_copy(r->z, z3);
+    return 0 - (uint64_t)(fp_is_zero(h) & fp_is_zero(rr));
+}
+
+void ecp_add(ecp *r, const ecp *a, const ecp *b, const group *g) {
+    ecp t;
+
+    if (ecp_is_infty(a)) {
+        *r = *b;
+        return;
+    }
+    if (ecp_is_infty(b)) {
+        *r = *a;
+        return;
+    }
+    if (ecp_add_raw(&t, a, b, g)) {
+        ecp_dbl(r, a, g);
+        return;
+    }
+    *r = t;
+}
+
+/* s的第pos位起的len位（len < 64） */
+static unsigned ecp_window(const uint64_t s[FP_DIGS], int pos, int len) {
+    uint64_t w = s[pos / 64] >> (pos % 64);
+
+    if (pos % 64 + len > 64 && pos / 64 + 1 < FP_DIGS)
+        w |= s[pos / 64 + 1] << (64 - pos % 64);
+    return (unsigned)(w & (((uint64_t)1 << len) - 1));
+}
+
+/* r = d * a，d为带符号奇数字，由W + 1位窗口v给出（d = v - 2^W）；扫描整张表，不按d访问内存 */
+static void ecp_lookup(ecp *r, const ecp *t, unsigned v, const group *g) {
+    uint64_t neg = 0 - (uint64_t)(((v >> ECP_W) & 1) ^ 1);
+    unsigned d = v - (1u << ECP_W), ad, idx;
+    ecp n;
+
+    /* |d|，d < 0时为2^W - v */
+    ad = (d ^ (unsigned)neg) + (unsigned)(neg & 1);
+    idx = (ad - 1) >> 1;
+    for (int i = 0; i < FP_DIGS; i++)
+        r->x[i] = r->y[i] = r->z[i] = 0;
+    for (unsigned j = 0; j < ECP_CT_TBL; j++)
+        ecp_cmov(r, &t[j], 0 - (uint64_t)(j == idx));
+    ecp_neg(&n, r, g);
+    ecp_cmov(r, &n, neg);
+}
+
+void ecp_mul_ct_table(ecp t[ECP_CT_TBL], const ecp *a, const group *g) {
+    ecp d;
+
+    /* t[j] = (2j + 1)a */
+    t[0] = *a;
+    ecp_dbl(&d, a, g);
+    for (int j = 1; j < ECP_CT_TBL; j++)
+        ecp_add_raw(&t[j], &t[j - 1], &d, g);
+}
+
+void ecp_mul_ct_tab(ecp *r, const ecp t[ECP_CT_TBL], const bn_t k, const group *g) {
+    ecp acc, q, d;
+    uint64_t s[FP_DIGS], ns[FP_DIGS], even, eq, borrow = 0;
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    int i, j;
+
+    // 越界的k先约简，分支只取决于k是否越界
+    if (k->sign == BN_NEG || bn_cmp(k, g->n) != BN_LT) {
+        bn_st *kr = bn_tmp(ar);
+        bn_mod(kr, k, g->n);
+        k = kr;
+    }
+
+    /*
+     * 取奇数标量s：k为奇数时s = k，否则s = n - k，最后把结果取负。s的W位带符号奇数字表示为
+     * s = sum(d_i 2^(Wi)) + top 2^(WL)，d_i = ((s >> Wi) | 1) mod 2^(W+1) - 2^W，top = (s >> WL) | 1，
+     * 每个窗口都恰好做W次倍点与一次加法。前缀的倍数在(0, n)内，只有最后一次加法可能遇到a = ±b，
+     * 因此最后一步同时计算倍点并按掩码选择（k = 0时s = n，最后一步得到无穷远点）
+     */
+    for (i = 0; i < FP_DIGS; i++) {
+        dig_t ki = (size_t)i < k->used ? k->dp[i] : 0;
+        dbl_t x = (dbl_t)g->fn.m[i] - ki - borrow;
+        s[i] = ki;
+        ns[i] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+    even = (s[0] & 1) - 1;
+    for (i = 0; i < FP_DIGS; i++)
+        s[i] = (s[i] & ~even) | (ns[i] & even);
+    arena_release(ar, mark);
+
+    /* 最高位数字为正，v = 2^W + top */
+    ecp_lookup(&acc, t, (1u << ECP_W) + (ecp_window(s, ECP_W * ECP_CT_DIGS, ECP_W + 1) | 1), g);
+    for (i = ECP_CT_DIGS - 1; i >= 0; i--) {
+        for (j = 0; j < ECP_W; j++)
+            ecp_dbl(&acc, &acc, g);
+        ecp_lookup(&q, t, ecp_window(s, ECP_W * i, ECP_W + 1) | 1, g);
+        if (i > 0) {
+            ecp_add_raw(&acc, &acc, &q, g);
+        } else {
+            ecp_dbl(&d, &acc, g);
+            eq = ecp_add_raw(&acc, &acc, &q, g);
+            ecp_cmov(&acc, &d, eq);
+        }
+    }
+
+    ecp_neg(&q, &acc, g);
+    ecp_cmov(&acc, &q, even);
+    *r = acc;
+}
+
+void ecp_mul_ct(ecp *r, const ecp *a, const bn_t k, const group *g) {
+    ecp t[ECP_CT_TBL];
+
+    ecp_mul_ct_table(t, a, g);
+    ecp_mul_ct_tab(r, t, k, g);
+}
+
+/* k的宽度ECP_W的wNAF，返回位数 */
+static int ecp_wnaf(int8_t naf[ECP_NAF_DIGS], const bn_t k) {
+    uint64_t t[FP_DIGS + 1];
+    int i, len = 0;
+
+    for (i = 0; i <= FP_DIGS; i++)
+        t[i] = (size_t)i < k->used ? k->dp[i] : 0;
+    while (t[0] | t[1] | t[2] | t[3] | t[4]) {
+        int d = 0;
+
+        if (t[0] & 1) {
+            d = (int)(t[0] & ((1u << ECP_W) - 1));
+            if (d >= 1 << (ECP_W - 1))
+                d -= 1 << ECP_W;
+            /* t -= d，之后t的低W位为0 */
+            if (d > 0) {
+                uint64_t c = (uint64_t)d;
+                for (i = 0; i <= FP_DIGS && c; i++) {
+                    uint64_t x = t[i];
+                    t[i] = x - c;
+                    c = x < c;
+                }
+            } else {
+                uint64_t c = (uint64_t)-d;
+                for (i = 0; i <= FP_DIGS && c; i++) {
+                    t[i] += c;
+                    c = t[i] < c;
+                }
+            }
+        }
+        naf[len++] = (int8_t)d;
+        for (i = 0; i < FP_DIGS; i++)
+            t[i] = (t[i] >> 1) | (t[i + 1] << 63);
+        t[FP_DIGS] >>= 1;
+    }
+    return len;
+}
+
+/* t[j] = (2j + 1)a */
+static void ecp_naf_table(ecp t[ECP_NAF_TBL], const ecp *a, const group *g) {
+    ecp d;
+
+    t[0] = *a;
+    ecp_dbl(&d, a, g);
+    for (int j = 1; j < ECP_NAF_TBL; j++)
+        ecp_add(&t[j], &t[j - 1], &d, g);
+}
+
+/* acc += d * t */
+static void ecp_naf_add(ecp *acc, const ecp t[ECP_NAF_TBL], int d, const group *g) {
+    ecp q;
+
+    if (d > 0) {
+        ecp_add(acc, acc, &t[d >> 1], g);
+    } else if (d < 0) {
+        ecp_neg(&q, &t[(-d) >> 1], g);
+        ecp_add(acc, acc, &q, g);
+    }
+}
+
+void ecp_mul2_vartime(ecp *r, const ecp *a, const bn_t k, const ecp *b, const bn_t l, const group *g) {
+    int8_t nk[ECP_NAF_DIGS], nl[ECP_NAF_DIGS];
+    ecp ta[ECP_NAF_TBL], tb[ECP_NAF_TBL], acc;
+    int lk, ll = 0, i;
+
+    lk = ecp_wnaf(nk, k);
+    if (lk > 0)
+        ecp_naf_table(ta, a, g);
+    if (b != NULL) {
+        ll = ecp_wnaf(nl, l);
+        if (ll > 0)
+            ecp_naf_table(tb, b, g);
+    }
+
+    ecp_set_infty(&acc, g);
+    for (i = (lk > ll ? lk : ll) - 1; i >= 0; i--) {
+        if (!ecp_is_infty(&acc))
+            ecp_dbl(&acc, &acc, g);
+        if (i < lk)
+            ecp_naf_add(&acc, ta, nk[i], g);
+        if (i < ll)
+            ecp_naf_add(&acc, tb, nl[i], g);
+    }
+    *r = acc;
+}
+
+void ecp_mul_point_ct(point *r, const point *a, const bn_t k, const group *g) {
+    ecp t;
+
+    ecp_set_point(&t, a, g);
+    ecp_mul_ct(&t, &t, k, g);
+    ecp_get_point(r, &t, g);
+}
+
+
+/*
+ * co-Z点运算（Goundar等）：两点共用同一个Z，只保存X、Y，Z不显式计算。
+ * p、q运算后仍共用一个Z，新Z为原Z乘以(Xp - Xq)（Xp为运算前的值）
+ */
+
+/* C = (Xp - Xq)^2，W1 = Xp C，W2 = Xq C，A1 = Yp(W1 - W2)，即p换到新Z下为(W1, A1) */
+static void ecp_zprep(fp_t w1, fp_t w2, fp_t a1, const fp_t xp, const fp_t yp, const fp_t xq, const fp_ctx *f) {
+    fp_t c;
+
+    fp_sub(c, xp, xq, f);
+    fp_sqr(c, c, f);
+    fp_mul(w1, xp, c, f);
+    fp_mul(w2, xq, c, f);
+    fp_sub(a1, w1, w2, f);
+    fp_mul(a1, a1, yp, f);
+}
+
+/* (X3, Y3) = (Xp, Yp) + (X, ±Y)：X3 = d^2 - W1 - W2，Y3 = d(W1 - X3) - A1，d = Yp ∓ Y */
+static void ecp_zsum(fp_t x3, fp_t y3, const fp_t d, const fp_t w1, const fp_t w2, const fp_t a1,
+                     const fp_ctx *f) {
+    fp_sqr(x3, d, f);
+    fp_sub(x3, x3, w1, f);
+    fp_sub(x3, x3, w2, f);
+    fp_sub(y3, w1, x3, f);
+    fp_mul(y3, y3, d, f);
+    fp_sub(y3, y3, a1, f);
+}
+
+/* q = p + q，p换到新Z下（4M + 2S） */
+static void ecp_zaddu(fp_t xp, fp_t yp, fp_t xq, fp_t yq, const fp_ctx *f) {
+    fp_t w1, w2, a1, d;
+
+    INSTR_COUNT(INSTR_POINT_ADD);
+    ecp_zprep(w1, w2, a1, xp, yp, xq, f);
+    fp_sub(d, yp, yq, f);
+    ecp_zsum(xq, yq, d, w1, w2, a1, f);
+    fp_copy(xp, w1);
+    fp_copy(yp, a1);
+}
+
+/* (p, q) = (p - q, p + q)（5M + 3S） */
+static void ecp_zaddc(fp_t xp, fp_t yp, fp_t xq, fp_t yq, const fp_ctx *f) {
+    fp_t w1, w2, a1, d, e;
+
+    INSTR_COUNT(INSTR_POINT_ADD);
+    ecp_zprep(w1, w2, a1, xp, yp, xq, f);
+    fp_sub(d, yp, yq, f);
+    fp_add(e, yp, yq, f);
+    ecp_zsum(xq, yq, d, w1, w2, a1, f);
+    ecp_zsum(xp, yp, e, w1, w2, a1, f);
+}
+
+/* mask为全1时交换a、b */
+static void fp_cswap(fp_t a, fp_t b, uint64_t mask) {
+    for (int i = 0; i < FP_DIGS; i++) {
+        uint64_t t = (a[i] ^ b[i]) & mask;
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+/* a == b时返回全1（a、b为FP_DIGS个字） */
+static uint64_t ecp_eq_mask(const uint64_t a[FP_DIGS], const uint64_t b[FP_DIGS]) {
+    uint64_t t = 0;
+
+    for (int i = 0; i < FP_DIGS; i++)
+        t |= a[i] ^ b[i];
+    return ((t | (0 - t)) >> 63) - 1;
+}
+
+int ecp_ladder(bn_t x, bn_t y, const point *a, const bn_t k, const group *g) {
+    const fp_ctx *f = &g->fp;
+    uint64_t s[FP_DIGS], c1[FP_DIGS + 1], c2[FP_DIGS + 1], kk[FP_DIGS + 1], v[FP_DIGS];
+    uint64_t sp, bit, prev = 0, m0, m1, mn1, mn2, carry, top;
+    fp_t xa, ya, xb, yb, px, py, t, num, den;
+    const fp_t zero = {0};
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    int i, len = bn_bit_len(g->n);
+
+    // x = 0的点无法由最后一步恢复Z，改用窗口法（a是公开的点）
+    if (bn_is_zero(a->x)) {
+        point r;
+        ecp_mul_point_ct(&r, a, k, g);
+        bn_copy(x, r.x);
+        if (y != NULL)
+            bn_copy(y, r.y);
+        return !point_is_infty(&r);
+    }
+
+    if (k->sign == BN_NEG || bn_cmp(k, g->n) != BN_LT) {
+        bn_st *kr = bn_tmp(ar);
+        bn_mod(kr, k, g->n);
+        k = kr;
+    }
+    for (i = 0; i < FP_DIGS; i++)
+        s[i] = (size_t)i < k->used ? k->dp[i] : 0;
+    arena_release(ar, mark);
+
+    /*
+     * k = 0, 1, n - 2, n - 1时阶梯中会出现无穷远点或相等的点，先按掩码换成k = 2，
+     * 最后再由2a、a与无穷远点选出结果
+     */
+    for (i = 0; i < FP_DIGS; i++)
+        v[i] = i == 0;
+    m1 = ecp_eq_mask(s, v);
+    v[0] = 0;
+    m0 = ecp_eq_mask(s, v);
+    for (i = 0, carry = 1; i < FP_DIGS; i++) {
+        dbl_t d = (dbl_t)g->fn.m[i] - carry;
+        v[i] = (uint64_t)d;
+        carry = (uint64_t)(d >> 64) & 1;
+    }
+    mn1 = ecp_eq_mask(s, v);
+    for (i = 0, carry = 1; i < FP_DIGS; i++) {
+        dbl_t d = (dbl_t)v[i] - carry;
+        v[i] = (uint64_t)d;
+        carry = (uint64_t)(d >> 64) & 1;
+    }
+    mn2 = ecp_eq_mask(s, v);
+    sp = m0 | m1 | mn1 | mn2;
+    s[0] = (s[0] & ~sp) | (2 & sp);
+    for (i = 1; i < FP_DIGS; i++)
+        s[i] &= ~sp;
+
+    /* 固定位长：k + n的第len位为1时取k + n，否则取k + 2n，两者都恰好有len + 1位 */
+    carry = 0;
+    for (i = 0; i < FP_DIGS; i++) {
+        dbl_t d = (dbl_t)s[i] + g->fn.m[i] + carry;
+        c1[i] = (uint64_t)d;
+        carry = (uint64_t)(d >> 64);
+    }
+    c1[FP_DIGS] = carry;
+    carry = 0;
+    for (i = 0; i < FP_DIGS; i++) {
+        dbl_t d = (dbl_t)c1[i] + g->fn.m[i] + carry;
+        c2[i] = (uint64_t)d;
+        carry = (uint64_t)(d >> 64);
+    }
+    c2[FP_DIGS] = c1[FP_DIGS] + carry;
+    top = 0 - ((c1[len / 64] >> (len % 64)) & 1);
+    for (i = 0; i <= FP_DIGS; i++)
+        kk[i] = (c1[i] & top) | (c2[i] & ~top);
+
+    /* 初始状态R0 = a、R1 = 2a，共用Z = 2y */
+    fp_from_bn(px, a->x, f);
+    fp_from_bn(py, a->y, f);
+    {
+        fp_t yy, m;
+
+        INSTR_COUNT(INSTR_POINT_DBL);
+        fp_sqr(yy, py, f);
+        fp_mul(xa, px, yy, f);
+        fp_dbl(xa, xa, f);
+        fp_dbl(xa, xa, f);
+        fp_sqr(ya, yy, f);
+        fp_dbl(ya, ya, f);
+        fp_dbl(ya, ya, f);
+        fp_dbl(ya, ya, f);
+        fp_sqr(m, px, f);
+        fp_tpl(m, m, f);
+        fp_add(m, m, g->ma, f);
+        fp_sqr(xb, m, f);
+        fp_dbl(t, xa, f);
+        fp_sub(xb, xb, t, f);
+        fp_sub(yb, xa, xb, f);
+        fp_mul(yb, yb, m, f);
+        fp_sub(yb, yb, ya, f);
+    }
+
+    /*
+     * 每一位：交换使(A, B) = (R_b, R_1-b)，(A, B) = (A - B, A + B)，再B' = B、A = B + A，
+     * 即A = 2R_b、B = R0 + R1。全程保持R1 - R0 = a
+     */
+    for (i = len - 1; i >= 0; i--) {
+        bit = 0 - ((kk[i / 64] >> (i % 64)) & 1);
+        fp_cswap(xa, xb, bit ^ prev);
+        fp_cswap(ya, yb, bit ^ prev);
+        prev = bit;
+        ecp_zaddc(xa, ya, xb, yb, f);
+        if (i == 0) {
+            /*
+             * 此时A = R_b - R_1-b = ±a（b = 1时为a），坐标为(x Z^2, ±y Z^3)，下一步后Z' = Z(XB - XA)，
+             * 故1 / Z' = ±y XA / (x YA (XB - XA))
+             */
+            fp_sub(t, zero, py, f);
+            fp_cmov(t, py, bit);
+            fp_mul(num, t, xa, f);
+            fp_sub(den, xb, xa, f);
+            fp_mul(den, den, ya, f);
+            fp_mul(den, den, px, f);
+        }
+        ecp_zaddu(xb, yb, xa, ya, f);
+    }
+    // 结果R0：最后一位为0时是A，为1时是B
+    fp_cswap(xa, xb, prev);
+    fp_cswap(ya, yb, prev);
+
+    fp_inv(den, den, f);
+    fp_mul(num, num, den, f);
+    fp_sqr(t, num, f);
+    fp_mul(xa, xa, t, f);
+    fp_mul(t, t, num, f);
+    fp_mul(ya, ya, t, f);
+
+    // 特殊标量：k = n - 2时取-2a，k = 1时取a，k = n - 1时取-a
+    fp_sub(t, zero, py, f);
+    fp_sub(yb, zero, ya, f);
+    fp_cmov(ya, yb, mn2);
+    fp_cmov(xa, px, m1 | mn1);
+    fp_cmov(ya, py, m1);
+    fp_cmov(ya, t, mn1);
+
+    if (m0) {
+        bn_zero(x);
+        if (y != NULL)
+            bn_zero(y);
+        return 0;
+    }
+    fp_to_bn(x, xa, f);
+    if (y != NULL)
+        fp_to_bn(y, ya, f);
+    return 1;
+}
@@ -0,0 +1,529 @@
+#include "fp.h"
+#include "cpu.h"
+#include "instr.h"
+#include <stddef.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FP_ADX
+#endif
+
+/* c = t - m if (hi, t) >= m, else t; t is 256 bits plus the carry word hi (hi <= 1) */
+static void fp_reduce_once(fp_t c, const uint64_t t[FP_DIGS], uint64_t hi, const fp_t m) {
+    uint64_t d[FP_DIGS], borrow = 0, mask;
+
+    for (int i = 0; i < FP_DIGS; i++) {
+        dbl_t s = (dbl_t)t[i] - m[i] - borrow;
+        d[i] = (uint64_t)s;
+        borrow = (uint64_t)(s >> 64) & 1;
+    }
+    /* keep t only when the subtraction borrowed out of hi */
+    mask = 0 - (uint64_t)(borrow > hi);
+    for (int i = 0; i < FP_DIGS; i++)
+        c[i] = (t[i] & mask) | (d[i] & ~mask);
+}
+
+/* CIOS Montgomery multiplication */
+static void fp_mont_mul(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx) {
+    uint64_t t[FP_DIGS + 2] = {0}, u, carry;
+    dbl_t acc;
+    int i, j;
+
+    for (i = 0; i < FP_DIGS; i++) {
+        /* t += a * b[i] */
+        carry = 0;
+        for (j = 0; j < FP_DIGS; j++) {
+            acc = (dbl_t)a[j] * b[i] + t[j] + carry;
+            t[j] = (uint64_t)acc;
+            carry = (uint64_t)(acc >> 64);
+        }
+        acc = (dbl_t)t[FP_DIGS] + carry;
+        t[FP_DIGS] = (uint64_t)acc;
+        t[FP_DIGS + 1] = (uint64_t)(acc >> 64);
+
+        /* t = (t + u * m) / 2^64 */
+        u = t[0] * ctx->n0;
+        acc = (dbl_t)u * ctx->m[0] + t[0];
+        carry = (uint64_t)(acc >> 64);
+        for (j = 1; j < FP_DIGS; j++) {
+            acc = (dbl_t)u * ctx->m[j] + t[j] + carry;
+            t[j - 1] = (uint64_t)acc;
+            carry = (uint64_t)(acc >> 64);
+        }
+        acc = (dbl_t)t[FP_DIGS] + carry;
+        t[FP_DIGS - 1] = (uint64_t)acc;
+        t[FP_DIGS] = t[FP_DIGS + 1] + (uint64_t)(acc >> 64);
+    }
+    fp_reduce_once(c, t, t[FP_DIGS], ctx->m);
+}
+
+#ifdef FP_ADX
+
+/*
+ * x86-64 kernels using MULX (flag-free multiply) and ADCX/ADOX, which carry through CF and OF
+ * independently, so the low and high halves of each row of partial products are accumulated
+ * on two interleaved carry chains. A product is formed in full (512 bits) and then reduced.
+ * Selected at run time when the CPU has BMI2 and ADX; fp_mont_mul above is the reference.
+ */
+
+_Static_assert(offsetof(fp_ctx, m) == 0, "fp_ctx.m must come first");
+
+/* one row of t += a * b[i]: A is the lowest live limb, E receives the new top limb */
+#define FP_ADX_ROW(OB, OT, A, B, C, D, E)                                                                              \
+    "movq " #OB "(%[b]), %%rdx\n\t"                                                                                    \
+    "xorl %k[z], %k[z]\n\t"                                                                                            \
+    "mulxq 0(%[a]), %[lo], %[hi]\n\t"                                                                                  \
+    "adcxq %[lo], %[" #A "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #B "]\n\t"                                                                                       \
+    "mulxq 8(%[a]), %[lo], %[hi]\n\t"                                                                                  \
+    "adcxq %[lo], %[" #B "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #C "]\n\t"                                                                                       \
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"                                                                                 \
+    "adcxq %[lo], %[" #C "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #D "]\n\t"                                                                                       \
+    "mulxq 24(%[a]), %[lo], %[" #E "]\n\t"                                                                             \
+    "adcxq %[lo], %[" #D "]\n\t"                                                                                       \
+    "adoxq %[z], %[" #E "]\n\t"                                                                                        \
+    "adcxq %[z], %[" #E "]\n\t"                                                                                        \
+    "movq %[" #A "], " #OT "(%[t])\n\t"
+
+/* t[0..8) = a * b */
+static void fp_mul_512_adx(uint64_t t[2 * FP_DIGS], const fp_t a, const fp_t b) {
+    uint64_t x0, x1, x2, x3, x4, lo, hi, z;
+
+    __asm__ volatile(
+        /* row 0 needs a single carry chain */
+        "movq 0(%[b]), %%rdx\n\t"
+        "mulxq 0(%[a]), %[x0], %[x1]\n\t"
+        "mulxq 8(%[a]), %[lo], %[x2]\n\t"
+        "addq %[lo], %[x1]\n\t"
+        "mulxq 16(%[a]), %[lo], %[x3]\n\t"
+        "adcq %[lo], %[x2]\n\t"
+        "mulxq 24(%[a]), %[lo], %[x4]\n\t"
+        "adcq %[lo], %[x3]\n\t"
+        "adcq $0, %[x4]\n\t"
+        "movq %[x0], 0(%[t])\n\t"
+        FP_ADX_ROW(8, 8, x1, x2, x3, x4, x0)
+        FP_ADX_ROW(16, 16, x2, x3, x4, x0, x1)
+        FP_ADX_ROW(24, 24, x3, x4, x0, x1, x2)
+        "movq %[x4], 32(%[t])\n\t"
+        "movq %[x0], 40(%[t])\n\t"
+        "movq %[x1], 48(%[t])\n\t"
+        "movq %[x2], 56(%[t])\n\t"
+        : [x0] "=&r"(x0), [x1] "=&r"(x1), [x2] "=&r"(x2), [x3] "=&r"(x3), [x4] "=&r"(x4), [lo] "=&r"(lo),
+          [hi] "=&r"(hi), [z] "=&r"(z)
+        : [a] "r"(a), [b] "r"(b), [t] "r"(t)
+        : "rdx", "cc", "memory");
+}
+
+/* t[0..8) = a^2: six cross products doubled, plus the four squares */
+static void fp_sqr_512_adx(uint64_t t[2 * FP_DIGS], const fp_t a) {
+    uint64_t x1, x2, x3, x4, x5, x6, x7, lo, hi;
+
+    __asm__ volatile(
+        /* a0 * (a1, a2, a3) at limbs 1..4 */
+        "movq 0(%[a]), %%rdx\n\t"
+        "mulxq 8(%[a]), %[x1], %[x2]\n\t"
+        "mulxq 16(%[a]), %[lo], %[x3]\n\t"
+        "addq %[lo], %[x2]\n\t"
+        "mulxq 24(%[a]), %[lo], %[x4]\n\t"
+        "adcq %[lo], %[x3]\n\t"
+        "adcq $0, %[x4]\n\t"
+        /* a1 * (a2, a3) at limbs 3..5 */
+        "movq 8(%[a]), %%rdx\n\t"
+        "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+        "addq %[lo], %[x3]\n\t"
+        "adcq %[hi], %[x4]\n\t"
+        "movl $0, %k[x5]\n\t"
+        "adcq $0, %[x5]\n\t"
+        "mulxq 24(%[a]), %[lo], %[hi]\n\t"
+        "addq %[lo], %[x4]\n\t"
+        "adcq %[hi], %[x5]\n\t"
+        /* a2 * a3 at limbs 5..6 */
+        "movq 16(%[a]), %%rdx\n\t"
+        "mulxq 24(%[a]), %[lo], %[x6]\n\t"
+        "addq %[lo], %[x5]\n\t"
+        "adcq $0, %[x6]\n\t"
+        /* double the cross products */
+        "movl $0, %k[x7]\n\t"
+        "addq %[x1], %[x1]\n\t"
+        "adcq %[x2], %[x2]\n\t"
+        "adcq %[x3], %[x3]\n\t"
+        "adcq %[x4], %[x4]\n\t"
+        "adcq %[x5], %[x5]\n\t"
+        "adcq %[x6], %[x6]\n\t"
+        "adcq $0, %[x7]\n\t"
+        /* add a_i^2 at limbs 2i, 2i+1 (mov and mulx leave the flags alone) */
+        "movq 0(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "movq %[lo], 0(%[t])\n\t"
+        "addq %[hi], %[x1]\n\t"
+        "movq 8(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[x2]\n\t"
+        "adcq %[hi], %[x3]\n\t"
+        "movq 16(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[x4]\n\t"
+        "adcq %[hi], %[x5]\n\t"
+        "movq 24(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[x6]\n\t"
+        "adcq %[hi], %[x7]\n\t"
+        "movq %[x1], 8(%[t])\n\t"
+        "movq %[x2], 16(%[t])\n\t"
+        "movq %[x3], 24(%[t])\n\t"
+        "movq %[x4], 32(%[t])\n\t"
+        "movq %[x5], 40(%[t])\n\t"
+        "movq %[x6], 48(%[t])\n\t"
+        "movq %[x7], 56(%[t])\n\t"
+        : [x1] "=&r"(x1), [x2] "=&r"(x2), [x3] "=&r"(x3), [x4] "=&r"(x4), [x5] "=&r"(x5), [x6] "=&r"(x6),
+          [x7] "=&r"(x7), [lo] "=&r"(lo), [hi] "=&r"(hi)
+        : [a] "r"(a), [t] "r"(t)
+        : "rdx", "cc", "memory");
+}
+
+/*
+ * one Montgomery step: u = A * n0, (A..E) += u * m so that A becomes 0, then the next limb of the
+ * upper half and the running carry cy are folded into E
+ */
+#define FP_ADX_RED(OT, A, B, C, D, E)                                                                                  \
+    "movq %[" #A "], %%rdx\n\t"                                                                                        \
+    "imulq %c[n0](%[ctx]), %%rdx\n\t"                                                                                  \
+    "xorl %k[z], %k[z]\n\t"                                                                                            \
+    "mulxq 0(%[ctx]), %[lo], %[hi]\n\t"                                                                                \
+    "adcxq %[lo], %[" #A "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #B "]\n\t"                                                                                       \
+    "mulxq 8(%[ctx]), %[lo], %[hi]\n\t"                                                                                \
+    "adcxq %[lo], %[" #B "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #C "]\n\t"                                                                                       \
+    "mulxq 16(%[ctx]), %[lo], %[hi]\n\t"                                                                               \
+    "adcxq %[lo], %[" #C "]\n\t"                                                                                       \
+    "adoxq %[hi], %[" #D "]\n\t"                                                                                       \
+    "mulxq 24(%[ctx]), %[lo], %[" #E "]\n\t"                                                                           \
+    "adcxq %[lo], %[" #D "]\n\t"                                                                                       \
+    "adoxq %[z], %[" #E "]\n\t"                                                                                        \
+    "adcxq %[z], %[" #E "]\n\t"                                                                                        \
+    "addq %[cy], %[" #E "]\n\t"                                                                                        \
+    "movl $0, %k[cy]\n\t"                                                                                              \
+    "adcq $0, %[cy]\n\t"                                                                                               \
+    "addq " #OT "(%[t]), %[" #E "]\n\t"                                                                                \
+    "adcq $0, %[cy]\n\t"
+
+/* c = t * 2^-256 mod m for t < m * 2^256 */
+static void fp_mont_red_adx(fp_t c, const uint64_t t[2 * FP_DIGS], const fp_ctx *ctx) {
+    uint64_t x0, x1, x2, x3, x4, lo, hi, z, cy;
+
+    __asm__ volatile(
+        "movq 0(%[t]), %[x0]\n\t"
+        "movq 8(%[t]), %[x1]\n\t"
+        "movq 16(%[t]), %[x2]\n\t"
+        "movq 24(%[t]), %[x3]\n\t"
+        "xorl %k[cy], %k[cy]\n\t"
+        FP_ADX_RED(32, x0, x1, x2, x3, x4)
+        FP_ADX_RED(40, x1, x2, x3, x4, x0)
+        FP_ADX_RED(48, x2, x3, x4, x0, x1)
+        FP_ADX_RED(56, x3, x4, x0, x1, x2)
+        /* (cy, x2, x1, x0, x4) < 2m: subtract m unless that borrows */
+        "movq %[x4], %[lo]\n\t"
+        "subq 0(%[ctx]), %[lo]\n\t"
+        "movq %[x0], %[hi]\n\t"
+        "sbbq 8(%[ctx]), %[hi]\n\t"
+        "movq %[x1], %[z]\n\t"
+        "sbbq 16(%[ctx]), %[z]\n\t"
+        "movq %[x2], %[x3]\n\t"
+        "sbbq 24(%[ctx]), %[x3]\n\t"
+        "sbbq $0, %[cy]\n\t"
+        "cmovcq %[x4], %[lo]\n\t"
+        "cmovcq %[x0], %[hi]\n\t"
+        "cmovcq %[x1], %[z]\n\t"
+        "cmovcq %[x2], %[x3]\n\t"
+        "movq %[lo], 0(%[c])\n\t"
+        "movq %[hi], 8(%[c])\n\t"
+        "movq %[z], 16(%[c])\n\t"
+        "movq %[x3], 24(%[c])\n\t"
+        : [x0] "=&r"(x0), [x1] "=&r"(x1), [x2] "=&r"(x2), [x3] "=&r"(x3), [x4] "=&r"(x4), [lo] "=&r"(lo),
+          [hi] "=&r"(hi), [z] "=&r"(z), [cy] "=&r"(cy)
+        : [t] "r"(t), [ctx] "r"(ctx), [c] "r"(c), [n0] "i"(offsetof(fp_ctx, n0))
+        : "rdx", "cc", "memory");
+}
+
+static int fp_have_adx(void) {
+    return (cpu_features() & (CPU_BMI2 | CPU_ADX)) == (CPU_BMI2 | CPU_ADX);
+}
+
+#endif
+
+/* a (in [0, m)) as 4 digits */
+static void fp_digits(fp_t c, const bn_t a) {
+    for (int i = 0; i < FP_DIGS; i++)
+        c[i] = (size_t)i < a->used ? a->dp[i] : 0;
+}
+
+/* e的第i位 */
+static int fp_bit(const fp_t e, int i) {
+    return (int)((e[i / 64] >> (i % 64)) & 1);
+}
+
+/* 以宽度w的滑动窗口分解e，返回乘法步数 */
+static int fp_chain_build(fp_chain *ch, const fp_t e, int w) {
+    int i, j, k, n = 0, low = 0;
+    unsigned v;
+
+    for (i = FP_DIGS * 64 - 1; i >= 0 && !fp_bit(e, i); i--)
+        ;
+    while (i >= 0) {
+        if (!fp_bit(e, i)) {
+            i--;
+            continue;
+        }
+        /* 窗口[j, i]：最高位与最低位均为1，宽度不超过w */
+        for (j = i - w + 1 < 0 ? 0 : i - w + 1; !fp_bit(e, j); j++)
+            ;
+        for (v = 0, k = i; k >= j; k--)
+            v = (v << 1) | (unsigned)fp_bit(e, k);
+        /* 先把已处理的高位左移到j处，再乘以a^v */
+        ch->sqr[n] = (uint16_t)(n == 0 ? 0 : low - j);
+        ch->idx[n] = (uint8_t)(v >> 1);
+        n++;
+        low = j;
+        i = j - 1;
+    }
+    ch->w = (uint8_t)w;
+    ch->n = (uint8_t)n;
+    ch->tail = (uint16_t)low;
+    return n;
+}
+
+void fp_chain_init(fp_chain *ch, const fp_t e) {
+    fp_chain t;
+    int w, cost, best = -1;
+
+    /* 平方次数与窗口宽度无关，只比较建表与窗口的乘法次数 */
+    for (w = 4; w <= 6; w++) {
+        cost = (1 << (w - 1)) - 1 + fp_chain_build(&t, e, w);
+        if (best < 0 || cost < best) {
+            best = cost;
+            *ch = t;
+        }
+    }
+}
+
+void fp_ctx_init(fp_ctx *ctx, const bn_t m) {
+    uint64_t inv = 1, borrow = 2, carry = 1;
+    fp_t e;
+    bn_t t;
+
+    fp_digits(ctx->m, m);
+
+    /* Newton iteration: each step doubles the number of correct low bits */
+    for (int i = 0; i < 6; i++)
+        inv *= 2 - ctx->m[0] * inv;
+    ctx->n0 = 0 - inv;
+
+    /* R mod m and R^2 mod m */
+    bn_new(t);
+    t->dp[FP_DIGS] = 1;
+    t->used = FP_DIGS + 1;
+    bn_mod(t, t, m);
+    fp_digits(ctx->one, t);
+
+    bn_new(t);
+    t->dp[2 * FP_DIGS] = 1;
+    t->used = 2 * FP_DIGS + 1;
+    bn_mod(t, t, m);
+    fp_digits(ctx->rr, t);
+
+    /* m - 2 */
+    for (int i = 0; i < FP_DIGS; i++) {
+        e[i] = ctx->m[i] - borrow;
+        borrow = ctx->m[i] < borrow;
+    }
+    fp_chain_init(&ctx->inv, e);
+
+    /* (m + 1) / 4 = (m >> 2) + 1 */
+    for (int i = 0; i < FP_DIGS; i++) {
+        e[i] = (ctx->m[i] >> 2) | (i + 1 < FP_DIGS ? ctx->m[i + 1] << 62 : 0);
+        e[i] += carry;
+        carry = carry && e[i] == 0;
+    }
+    fp_chain_init(&ctx->sqrt, e);
+}
+
+void fp_from_bn(fp_t c, const bn_t a, const fp_ctx *ctx) {
+    fp_t t;
+
+    /* t < 2^256、rr < m时乘积约简前小于2m，一次条件减法即落在[0, m)，因此t可以不小于m */
+    fp_digits(t, a);
+    fp_mont_mul(c, t, ctx->rr, ctx);
+}
+
+void fp_to_bn(bn_t c, const fp_t a, const fp_ctx *ctx) {
+    const fp_t one = {1, 0, 0, 0};
+    fp_t t;
+
+    fp_mont_mul(t, a, one, ctx);
+    c->alloc = BN_SIZE;
+    c->sign = BN_POS;
+    for (int i = 0; i < FP_DIGS; i++)
+        c->dp[i] = t[i];
+    c->used = FP_DIGS;
+    bn_trim(c);
+}
+
+void fp_add(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx) {
+    uint64_t t[FP_DIGS], carry = 0;
+
+    for (int i = 0; i < FP_DIGS; i++) {
+        dbl_t s = (dbl_t)a[i] + b[i] + carry;
+        t[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    fp_reduce_once(c, t, carry, ctx->m);
+}
+
+void fp_sub(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx) {
+    uint64_t t[FP_DIGS], borrow = 0, mask, carry = 0;
+
+    for (int i = 0; i < FP_DIGS; i++) {
+        dbl_t s = (dbl_t)a[i] - b[i] - borrow;
+        t[i] = (uint64_t)s;
+        borrow = (uint64_t)(s >> 64) & 1;
+    }
+    /* add m back if a < b */
+    mask = 0 - borrow;
+    for (int i = 0; i < FP_DIGS; i++) {
+        dbl_t s = (dbl_t)t[i] + (ctx->m[i] & mask) + carry;
+        c[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+}
+
+void fp_dbl(fp_t c, const fp_t a, const fp_ctx *ctx) {
+    uint64_t t[FP_DIGS], hi = a[FP_DIGS - 1] >> 63;
+
+    for (int i = FP_DIGS - 1; i > 0; i--)
+        t[i] = (a[i] << 1) | (a[i - 1] >> 63);
+    t[0] = a[0] << 1;
+    fp_reduce_once(c, t, hi, ctx->m);
+}
+
+void fp_tpl(fp_t c, const fp_t a, const fp_ctx *ctx) {
+    fp_t t;
+
+    fp_dbl(t, a, ctx);
+    fp_add(c, t, a, ctx);
+}
+
+void fp_mul(fp_t c, const fp_t a, const fp_t b, const fp_ctx *ctx) {
+    INSTR_COUNT(INSTR_MOD_MUL);
+#ifdef FP_ADX
+    if (fp_have_adx()) {
+        uint64_t t[2 * FP_DIGS];
+        fp_mul_512_adx(t, a, b);
+        fp_mont_red_adx(c, t, ctx);
+        return;
+    }
+#endif
+    fp_mont_mul(c, a, b, ctx);
+}
+
+void fp_sqr(fp_t c, const fp_t a, const fp_ctx *ctx) {
+    INSTR_COUNT(INSTR_MOD_SQR);
+#ifdef FP_ADX
+    if (fp_have_adx()) {
+        uint64_t t[2 * FP_DIGS];
+        fp_sqr_512_adx(t, a);
+        fp_mont_red_adx(c, t, ctx);
+        return;
+    }
+#endif
+    fp_mont_mul(c, a, a, ctx);
+}
+
+void fp_sqr_n(fp_t c, const fp_t a, int k, const fp_ctx *ctx) {
+    if (k == 0) {
+        fp_copy(c, a);
+        return;
+    }
+    fp_sqr(c, a, ctx);
+    while (--k > 0)
+        fp_sqr(c, c, ctx);
+}
+
+void fp_exp(fp_t c, const fp_t a, const fp_t e, const fp_ctx *ctx) {
+    fp_t t[16], r;
+    uint64_t w, mask;
+    int i, j, top;
+
+    /* t[i] = a^i */
+    fp_copy(t[0], ctx->one);
+    fp_copy(t[1], a);
+    for (i = 2; i < 16; i++)
+        fp_mul(t[i], t[i - 1], a, ctx);
+
+    for (top = FP_DIGS * 16 - 1; top > 0 && ((e[top / 16] >> (4 * (top % 16))) & 0xF) == 0; top--)
+        ;
+
+    /* fixed 4-bit window; the table lookup scans all entries */
+    fp_copy(r, ctx->one);
+    for (i = top; i >= 0; i--) {
+        fp_t s;
+
+        if (i != top)
+            for (j = 0; j < 4; j++)
+                fp_sqr(r, r, ctx);
+        w = (e[i / 16] >> (4 * (i % 16))) & 0xF;
+        for (j = 0; j < FP_DIGS; j++)
+            s[j] = 0;
+        for (j = 0; j < 16; j++) {
+            mask = 0 - (uint64_t)((uint64_t)j == w);
+            for (int k = 0; k < FP_DIGS; k++)
+                s[k] |= t[j][k] & mask;
+        }
+        fp_mul(r, r, s, ctx);
+    }
+    fp_copy(c, r);
+}
+
+void fp_exp_chain(fp_t c, const fp_t a, const fp_chain *ch, const fp_ctx *ctx) {
+    fp_t t[1 << 5], a2, r;
+    int i;
+
+    if (ch->n == 0) {
+        fp_copy(c, ctx->one);
+        return;
+    }
+
+    /* t[i] = a^(2i + 1) */
+    fp_copy(t[0], a);
+    fp_sqr(a2, a, ctx);
+    for (i = 1; i < 1 << (ch->w - 1); i++)
+        fp_mul(t[i], t[i - 1], a2, ctx);
+
+    fp_copy(r, t[ch->idx[0]]);
+    for (i = 1; i < ch->n; i++) {
+        fp_sqr_n(r, r, ch->sqr[i], ctx);
+        fp_mul(r, r, t[ch->idx[i]], ctx);
+    }
+    fp_sqr_n(c, r, ch->tail, ctx);
+}
+
+void fp_inv(fp_t c, const fp_t a, const fp_ctx *ctx) {
+    INSTR_COUNT(INSTR_MOD_INV);
+    fp_exp_chain(c, a, &ctx->inv, ctx);
+}
+
+int fp_sqrt(fp_t c, const fp_t a, const fp_ctx *ctx) {
+    fp_t r, t;
+
+    if ((ctx->m[0] & 3) != 3)
+        return 0;
+    fp_exp_chain(r, a, &ctx->sqrt, ctx);
+
+    /* a是平方剩余当且仅当r^2 = a */
+    fp_sqr(t, r, ctx);
+    if (!fp_equal(t, a))
+        return 0;
+    fp_copy(c, r);
+    return 1;
+}
@@ -0,0 +1,47 @@
+#include "instr.h"
+#include <string.h>
+
+static const char *INSTR_COUNTER_NAME[INSTR_COUNTERS] = {
+    "mod_mul", "mod_sqr", "mod_inv", "bn_div", "bn_new", "point_dbl", "point_add", "sm3_compress",
+};
+
+static const char *INSTR_STAGE_NAME[INSTR_STAGES] = {"z", "e", "scalar_mul", "final"};
+
+#ifdef SM2_INSTRUMENT
+
+_Thread_local instr_counters instr_tls;
+
+int instr_enabled(void) {
+    return 1;
+}
+
+void instr_snapshot(instr_counters *out) {
+    *out = instr_tls;
+}
+
+void instr_reset(void) {
+    memset(&instr_tls, 0, sizeof(instr_tls));
+}
+
+#else
+
+int instr_enabled(void) {
+    return 0;
+}
+
+void instr_snapshot(instr_counters *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+void instr_reset(void) {
+}
+
+#endif
+
+const char *instr_counter_name(instr_counter c) {
+    return (unsigned int)c < INSTR_COUNTERS ? INSTR_COUNTER_NAME[c] : "?";
+}
+
+const char *instr_stage_name(instr_stage s) {
+    return (unsigned int)s < INSTR_STAGES ? INSTR_STAGE_NAME[s] : "?";
+}
@@ -1,5 +1,6 @@
 #include "point.h"
 #include "bn.h"
+#include "instr.h"
 
 void point_new(point *p) {
     bn_new(p->x);
@@ -23,6 +24,64 @@ int point_is_infty(const point *a) {
     return bn_is_zero(a->x) && bn_is_zero(a->y);
 }
 
+// 检查 y^2 = x^3 + ax + b (mod p)，坐标需在[0, p)内
+int point_on_curve(const point *g, const bn_t p, const bn_t a, const bn_t b) {
+    if (g->x->sign == BN_NEG || g->y->sign == BN_NEG || bn_cmp(g->x, p) != BN_LT || bn_cmp(g->y, p) != BN_LT)
+        return 0;
+
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *l = bn_tmp(ar), *r = bn_tmp(ar);
+    int ok;
+
+    // l = y^2
+    bn_mod_sqr(l, g->y, p);
+    // r = (x^2 + a) * x + b
+    bn_mod_sqr(r, g->x, p);
+    bn_mod_add(r, r, a, p);
+    bn_mod_mul(r, r, g->x, p);
+    bn_mod_add(r, r, b, p);
+
+    ok = bn_cmp(l, r) == BN_EQ;
+    arena_release(ar, mark);
+    return ok;
+}
+
+// 由x坐标与y的奇偶性恢复点（要求p = 3 mod 4），x不对应曲线上的点时返回0
+int point_decompress(point *c, const bn_t x, int y_odd, const bn_t p, const bn_t a, const bn_t b) {
+    if (x->sign == BN_NEG || bn_cmp(x, p) != BN_LT)
+        return 0;
+
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t = bn_tmp(ar), *y = bn_tmp(ar);
+    int ok = 0;
+
+    // t = (x^2 + a) * x + b
+    bn_mod_sqr(t, x, p);
+    bn_mod_add(t, t, a, p);
+    bn_mod_mul(t, t, x, p);
+    bn_mod_add(t, t, b, p);
+
+    // y = t^((p + 1) / 4)
+    if (!bn_mod_sqrt(y, t, p))
+        goto end;
+
+    // 选取奇偶性匹配的根，y = 0时不存在奇数根
+    if ((int)(y->dp[0] & 1) != (y_odd & 1)) {
+        if (bn_is_zero(y))
+            goto end;
+        bn_sub(y, p, y);
+    }
+
+    bn_copy(c->x, x);
+    bn_copy(c->y, y);
+    ok = 1;
+end:
+    arena_release(ar, mark);
+    return ok;
+}
+
 void point_add(point *c, const point *g, const point *b, const bn_t p, const bn_t a) {
     // 处理无穷远点的情况
     if (point_is_infty(g)) {
@@ -48,13 +107,11 @@ void point_add(point *c, const point *g, const point *b, const bn_t p, const bn_
         return;
     }
 
-    bn_t t0, t1, t2, x3, y3;
-
-    bn_new(t0);
-    bn_new(t1);
-    bn_new(t2);
-    bn_new(x3);
-    bn_new(y3);
+    INSTR_COUNT(INSTR_POINT_ADD);
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t0 = bn_tmp(ar), *t1 = bn_tmp(ar), *t2 = bn_tmp(ar);
+    bn_st *x3 = bn_tmp(ar), *y3 = bn_tmp(ar);
 
     // t0 = x2 - x1
     bn_mod_sub(t0, b->x, g->x, p);
@@ -66,7 +123,7 @@ void point_add(point *c, const point *g, const point *b, const bn_t p, const bn_
     bn_mod_mul(t2, t1, t2, p);
 
     // x3 = lambda^2 - x1 - x2
-    bn_mod_mul(x3, t2, t2, p);
+    bn_mod_sqr(x3, t2, p);
     bn_mod_sub(x3, x3, g->x, p);
     bn_mod_sub(x3, x3, b->x, p);
 
@@ -77,6 +134,7 @@ void point_add(point *c, const point *g, const point *b, const bn_t p, const bn_
 
     bn_copy(c->x, x3);
     bn_copy(c->y, y3);
+    arena_release(ar, mark);
 }
 
 void point_dbl(point *c, const point *g, const bn_t p, const bn_t a) {
@@ -92,20 +150,16 @@ void point_dbl(point *c, const point *g, const bn_t p, const bn_t a) {
         return;
     }
 
-    bn_t t0, t1, t2, t3, x3, y3;
-
-    bn_new(t0);
-    bn_new(t1);
-    bn_new(t2);
-    bn_new(t3);
-    bn_new(x3);
-    bn_new(y3);
+    INSTR_COUNT(INSTR_POINT_DBL);
+    arena *ar = arena_thread();
+    size_t mark = arena_mark(ar);
+    bn_st *t0 = bn_tmp(ar), *t1 = bn_tmp(ar), *t2 = bn_tmp(ar), *t3 = bn_tmp(ar);
+    bn_st *x3 = bn_tmp(ar), *y3 = bn_tmp(ar);
 
     // t0 = x1^2
-    bn_mod_mul(t0, g->x, g->x, p);
+    bn_mod_sqr(t0, g->x, p);
     // t1 = 3x1^2 + a
-    bn_mod_add(t1, t0, t0, p);
-    bn_mod_add(t1, t1, t0, p);
+    bn_mod_tpl(t1, t0, p);
     bn_mod_add(t1, t1, a, p);
     // t2 = 2y1
     bn_mod_add(t2, g->y, g->y, p);
@@ -115,9 +169,9 @@ void point_dbl(point *c, const point *g, const bn_t p, const bn_t a) {
     bn_mod_mul(t3, t1, t3, p);
 
     // x3 = lambda^2 - 2x1
-    bn_mod_mul(x3, t3, t3, p);
-    bn_mod_sub(x3, x3, g->x, p);
-    bn_mod_sub(x3, x3, g->x, p);
+    bn_mod_sqr(x3, t3, p);
+    bn_mod_dbl(t0, g->x, p);
+    bn_mod_sub(x3, x3, t0, p);
 
     // y3 = lambda(x1 - x3) - y1
     bn_mod_sub(y3, g->x, x3, p);
@@ -126,6 +180,7 @@ void point_dbl(point *c, const point *g, const bn_t p, const bn_t a) {
 
     bn_copy(c->x, x3);
     bn_copy(c->y, y3);
+    arena_release(ar, mark);
 }
 
 void point_mul(point *c, const point *g, const bn_t k, const bn_t p, const bn_t a) {
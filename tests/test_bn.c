@@ -0,0 +1,134 @@
+#include "SM2.h"
+#include "bn.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * 掩码修正的模加减差分测试（模p与模n两个模数）：bn_mod_add/bn_mod_sub/bn_mod_dbl/bn_mod_tpl
+ * 与参考实现bn_add/bn_sub + bn_mod逐个比较，共2 × CASES组操作数。
+ * 操作数为固定种子的伪随机数，按用例序号轮流构造a + b = m、a = b、0、m - 1、输出与输入同址、
+ * 未约简（a + m）与负数输入等情况；后两种走bn_mod的回退路径。
+ */
+
+#define CASES 20000 /* 每个模数的用例数 */
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+/* splitmix64，固定种子，失败可复现 */
+static uint64_t rng_next(void) {
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* [0, m)内的伪随机数 */
+static void rand_mod(bn_t a, const bn_t m) {
+    uint8_t buf[SM2_SCALAR_SIZE];
+
+    for (size_t i = 0; i < sizeof(buf); i += 8) {
+        uint64_t w = rng_next();
+        for (int j = 0; j < 8; j++)
+            buf[i + j] = (uint8_t)(w >> (8 * j));
+    }
+    bn_from_bytes(a, buf, sizeof(buf));
+    bn_mod(a, a, m);
+}
+
+/* 参考实现：c = (a + b) mod m或(a - b) mod m */
+static void ref_op(bn_t c, const bn_t a, const bn_t b, const bn_t m, int sub) {
+    bn_t t;
+
+    bn_new(t);
+    if (sub)
+        bn_sub(t, a, b);
+    else
+        bn_add(t, a, b);
+    bn_mod(c, t, m);
+}
+
+/* 检查c是否与r相等，不相等时打印前几处 */
+static void check(const char *op, const bn_t c, const bn_t r, int i, int *bad) {
+    if (bn_cmp(c, r) == BN_EQ)
+        return;
+    if (++*bad <= 5)
+        printf("  %s mismatch at case %d\n", op, i);
+}
+
+static int run(const bn_t m, uint64_t seed) {
+    bn_t a, b, c, r, t;
+    int bad = 0;
+
+    bn_new(a);
+    bn_new(b);
+    bn_new(c);
+    bn_new(r);
+    bn_new(t);
+    rng_state = seed;
+    for (int i = 0; i < CASES; i++) {
+        rand_mod(a, m);
+        rand_mod(b, m);
+        switch (i % 10) {
+        case 1: bn_sub(b, m, a); break; /* a + b = m */
+        case 2: bn_copy(b, a); break;
+        case 3: bn_zero(a); break;
+        case 4: bn_sub_dig(a, m, 1); break;
+        case 5:
+            bn_sub_dig(a, m, 1);
+            bn_sub_dig(b, m, 1);
+            break;
+        case 6: bn_add(a, a, m); break; /* 未约简 */
+        case 7: bn_neg(b, b); break;    /* 负数 */
+        }
+
+        bn_mod_add(c, a, b, m);
+        ref_op(r, a, b, m, 0);
+        check("bn_mod_add", c, r, i, &bad);
+
+        bn_mod_sub(c, a, b, m);
+        ref_op(r, a, b, m, 1);
+        check("bn_mod_sub", c, r, i, &bad);
+
+        bn_mod_dbl(c, a, m);
+        ref_op(r, a, a, m, 0);
+        check("bn_mod_dbl", c, r, i, &bad);
+
+        bn_mod_tpl(c, a, m);
+        ref_op(t, a, a, m, 0);
+        ref_op(r, t, a, m, 0);
+        check("bn_mod_tpl", c, r, i, &bad);
+
+        // 输出与输入同址
+        bn_copy(c, a);
+        bn_mod_add(c, c, b, m);
+        ref_op(r, a, b, m, 0);
+        check("bn_mod_add (alias)", c, r, i, &bad);
+
+        bn_copy(c, b);
+        bn_mod_sub(c, a, c, m);
+        ref_op(r, a, b, m, 1);
+        check("bn_mod_sub (alias)", c, r, i, &bad);
+    }
+    return bad;
+}
+
+int main(void) {
+    group g;
+    const bn_st *mods[2];
+    const char *names[2] = {"p", "n"};
+    int bad = 0, b;
+
+    create_group(&g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
+                 SM2_CURVE_PARAM_N);
+    mods[0] = g.p;
+    mods[1] = g.n;
+
+    for (int k = 0; k < 2; k++) {
+        b = run(mods[k], 0xB00C0000ull + k);
+        printf("bn_mod add/sub/dbl/tpl mod %s: %d cases, %d mismatches\n", names[k], CASES, b);
+        bad += b;
+    }
+
+    printf("%s\n", bad ? "FAILED" : "all bn modular add/sub checks passed");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+#include "SM2.h"
+#include "arena.h"
+#include "batch.h"
+#include "cpu.h"
+#include "fp.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 定长域运算的差分测试（模p与模n两个上下文）：
+ *   1. fp_from_bn/fp_mul/fp_sqr与bn_mod/bn_mod_mul/bn_mod_sqr比较；
+ *   2. 同一组操作数先走当前CPU上的MULX/ADX汇编，再屏蔽BMI2与ADX走可移植的fp_mont_mul，结果逐位比较；
+ *   3. fp_vec_mul依次在AVX-512 IFMA、AVX2与标量实现下与fp_mul逐元素比较（含n不是BATCH_LANES的倍数、
+ *      stride大于n的情况，并检查n所在分组之后的元素未被改写），fp_vec_inv与fp_inv逐元素比较。
+ * 操作数为固定种子的伪随机数与边界值（0、1、m - 1，以及fp_from_bn的不小于m的输入）。
+ * 用法：test_fp [--disable MASK]，MASK为预先屏蔽的CPU_*特性（如0x3f只测可移植实现）。
+ */
+
+#define CASES     2000 /* 每个上下文的随机用例数 */
+#define EDGES     9    /* 边界值个数 */
+#define VEC_MAX   64   /* 批量测试的最大元素数（即stride） */
+#define MEM_SIZE  (1 << 20)
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+/* splitmix64，固定种子，失败可复现 */
+static uint64_t rng_next(void) {
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void bn_from_words(bn_t a, const uint64_t w[FP_DIGS]) {
+    uint8_t buf[FP_DIGS * 8];
+
+    for (int i = 0; i < FP_DIGS; i++)
+        for (int j = 0; j < 8; j++)
+            buf[(FP_DIGS - 1 - i) * 8 + 7 - j] = (uint8_t)(w[i] >> (8 * j));
+    bn_from_bytes(a, buf, sizeof(buf));
+}
+
+/* 第i个操作数：前EDGES个为边界值，之后为随机值（约一半先模m约简，另一半保留原值，可能不小于m） */
+static void operand(bn_t a, size_t i, const bn_t m) {
+    uint64_t w[FP_DIGS];
+
+    switch (i) {
+    case 0: bn_zero(a); return;
+    case 1: bn_set_dig(a, 1); return;
+    case 2: bn_set_dig(a, 2); return;
+    case 3: bn_sub_dig(a, m, 1); return;
+    case 4: bn_sub_dig(a, m, 2); return;
+    case 5: bn_copy(a, m); return;
+    case 6: bn_add_dig(a, m, 1); return;
+    case 7:
+        for (int j = 0; j < FP_DIGS; j++)
+            w[j] = ~(uint64_t)0;
+        bn_from_words(a, w);
+        return;
+    case 8:
+        for (int j = 0; j < FP_DIGS; j++)
+            w[j] = 0;
+        w[FP_DIGS - 1] = (uint64_t)1 << 63;
+        bn_from_words(a, w);
+        return;
+    }
+    for (int j = 0; j < FP_DIGS; j++)
+        w[j] = rng_next();
+    bn_from_words(a, w);
+    if (i & 1)
+        bn_mod(a, a, m);
+}
+
+/* 一个用例的结果：fp_from_bn(a)、fp_from_bn(b)、a * b、a^2，以及原始字a = m - 1、b = 1时的乘积 */
+typedef struct {
+    fp_t fa, fb, mul, sqr, raw;
+} fp_case;
+
+/* 用当前路径计算全部用例并与bn参考实现比较，返回不一致的个数 */
+static int run_scalar(fp_case *out, const fp_ctx *ctx, const bn_t m, uint64_t seed) {
+    bn_t a, b, ar, br, ref, got;
+    fp_t one = {1, 0, 0, 0}, mm1;
+    int bad = 0;
+
+    bn_new(a);
+    bn_new(b);
+    bn_new(ar);
+    bn_new(br);
+    bn_new(ref);
+    bn_new(got);
+    rng_state = seed;
+    for (int j = 0; j < FP_DIGS; j++)
+        mm1[j] = ctx->m[j];
+    mm1[0] -= 1;
+    for (size_t i = 0; i < CASES; i++) {
+        fp_case *c = &out[i];
+
+        operand(a, i, m);
+        operand(b, (i * 7 + 3) % CASES, m);
+        bn_mod(ar, a, m);
+        bn_mod(br, b, m);
+
+        fp_from_bn(c->fa, a, ctx);
+        fp_from_bn(c->fb, b, ctx);
+        fp_to_bn(got, c->fa, ctx);
+        bad += bn_cmp(got, ar) != BN_EQ;
+
+        fp_mul(c->mul, c->fa, c->fb, ctx);
+        fp_to_bn(got, c->mul, ctx);
+        bn_mod_mul(ref, ar, br, m);
+        bad += bn_cmp(got, ref) != BN_EQ;
+
+        fp_sqr(c->sqr, c->fa, ctx);
+        fp_to_bn(got, c->sqr, ctx);
+        bn_mod_sqr(ref, ar, m);
+        bad += bn_cmp(got, ref) != BN_EQ;
+
+        // 原始Montgomery字的边界：交替取m - 1与1
+        fp_mul(c->raw, (i & 1) ? mm1 : one, c->fb, ctx);
+        if (bad > 0 && bad <= 3)
+            printf("  mismatch at case %zu\n", i);
+    }
+    return bad;
+}
+
+static int cmp_cases(const fp_case *x, const fp_case *y) {
+    int bad = 0;
+
+    for (size_t i = 0; i < CASES; i++)
+        bad += memcmp(&x[i], &y[i], sizeof(fp_case)) != 0;
+    return bad;
+}
+
+/* fp_vec_mul与fp_mul、fp_vec_inv与fp_inv逐元素比较 */
+static int run_vec(const fp_ctx *ctx, const bn_t m, arena *ar) {
+    static const size_t ns[] = {1, BATCH_LANES, 37, VEC_MAX};
+    size_t mark = arena_mark(ar);
+    point_batch A, B, C;
+    fp_t x, y, r, e;
+    bn_t t;
+    int bad = 0;
+
+    bn_new(t);
+    point_batch_init(&A, ar, VEC_MAX);
+    point_batch_init(&B, ar, VEC_MAX);
+    point_batch_init(&C, ar, VEC_MAX);
+    for (size_t j = 0; j < VEC_MAX; j++) {
+        operand(t, EDGES + j, m);
+        fp_from_bn(x, t, ctx);
+        operand(t, j < EDGES ? j : EDGES + VEC_MAX + j, m);
+        fp_from_bn(y, t, ctx);
+        fp_vec_set(A.x, A.stride, j, x);
+        fp_vec_set(B.x, B.stride, j, y);
+    }
+
+    for (size_t k = 0; k < sizeof(ns) / sizeof(ns[0]); k++) {
+        size_t n = ns[k], end = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+        const fp_t mark_val = {0xA5A5A5A5A5A5A5A5ull, 1, 2, 3};
+
+        for (size_t j = 0; j < VEC_MAX; j++)
+            fp_vec_set(C.x, C.stride, j, mark_val);
+        fp_vec_mul(C.x, A.x, B.x, n, A.stride, ctx);
+        for (size_t j = 0; j < VEC_MAX; j++) {
+            fp_vec_get(r, C.x, C.stride, j);
+            if (j < n) {
+                fp_vec_get(x, A.x, A.stride, j);
+                fp_vec_get(y, B.x, B.stride, j);
+                fp_mul(e, x, y, ctx);
+                bad += !fp_equal(r, e);
+            } else if (j >= end) {
+                bad += !fp_equal(r, mark_val);
+            }
+        }
+
+        // 第5个元素置0：0的逆为0，且不影响其余元素
+        fp_vec_get(x, A.x, A.stride, 5 % n);
+        fp_vec_set(A.x, A.stride, 5 % n, (fp_t){0});
+        fp_vec_inv(C.x, A.x, n, A.stride, ctx, ar);
+        for (size_t j = 0; j < n; j++) {
+            fp_vec_get(r, C.x, C.stride, j);
+            fp_vec_get(y, A.x, A.stride, j);
+            fp_inv(e, y, ctx);
+            bad += !fp_equal(r, e);
+        }
+        fp_vec_set(A.x, A.stride, 5 % n, x);
+    }
+    arena_release(ar, mark);
+    return bad;
+}
+
+static const char *vec_backend(void) {
+    unsigned int f = cpu_features();
+
+    if ((f & (CPU_AVX512F | CPU_AVX512IFMA)) == (CPU_AVX512F | CPU_AVX512IFMA))
+        return "avx512ifma";
+    if (f & CPU_AVX2)
+        return "avx2";
+    return "c";
+}
+
+int main(int argc, char *argv[]) {
+    static fp_case fast[2][CASES], portable[CASES];
+    group g;
+    fp_ctx ctx[2];
+    const bn_st *mods[2];
+    const char *names[2] = {"p", "n"};
+    void *mem;
+    arena ar;
+    int bad = 0, b, adx;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--disable") == 0 && i + 1 < argc) {
+            cpu_disable((unsigned int)strtoul(argv[++i], NULL, 0));
+        } else {
+            fprintf(stderr, "usage: %s [--disable MASK]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    create_group(&g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
+                 SM2_CURVE_PARAM_N);
+    mods[0] = g.p;
+    mods[1] = g.n;
+    mem = malloc(MEM_SIZE);
+    if (mem == NULL)
+        return 2;
+    arena_init(&ar, mem, MEM_SIZE);
+
+    for (int k = 0; k < 2; k++)
+        fp_ctx_init(&ctx[k], mods[k]);
+
+    // 批量乘法：每轮屏蔽一级特性，依次覆盖IFMA、AVX2与标量实现（已屏蔽的级别会重复测试标量实现）
+    for (int level = 0; level < 3; level++) {
+        for (int k = 0; k < 2; k++) {
+            b = run_vec(&ctx[k], mods[k], &ar);
+            printf("fp_vec mod %s [%s]: %d mismatches\n", names[k], vec_backend(), b);
+            bad += b;
+        }
+        cpu_disable(level == 0 ? CPU_AVX512IFMA : CPU_AVX2);
+    }
+
+    // 标量乘法：两个上下文先走当前路径并与bn比较，再屏蔽BMI2/ADX后与可移植实现逐位比较
+    adx = (cpu_features() & (CPU_BMI2 | CPU_ADX)) == (CPU_BMI2 | CPU_ADX);
+    for (int k = 0; k < 2; k++) {
+        b = run_scalar(fast[k], &ctx[k], mods[k], 0x5EED0000ull + k);
+        printf("fp mod %s [%s] vs bn: %d mismatches\n", names[k], adx ? "adx" : "c", b);
+        bad += b;
+    }
+    if (adx) {
+        cpu_disable(CPU_BMI2 | CPU_ADX);
+        for (int k = 0; k < 2; k++) {
+            b = run_scalar(portable, &ctx[k], mods[k], 0x5EED0000ull + k);
+            b += cmp_cases(fast[k], portable);
+            printf("fp mod %s [adx] vs [c]: %d mismatches\n", names[k], b);
+            bad += b;
+        }
+    } else {
+        printf("fp: MULX/ADX path not available, only the portable path was tested\n");
+    }
+
+    free(mem);
+    printf("%s\n", bad ? "FAILED" : "all fp differential checks passed");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,530 @@
+#include "SM2.h"
+#include "SM3.h"
+#include "SM3_tree.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define IO_BUFFER_SIZE  ((size_t)4 << 20) /* 每个读缓冲区4 MiB */
+#define IO_BUFFER_ALIGN 4096              /* 按页对齐 */
+#define DEFAULT_ID      "1234567812345678"
+
+/* 输入文件：能映射时直接使用映射内存，否则双缓冲读取 */
+typedef struct {
+    int fd;
+    const uint8_t *map; /* 映射地址，未映射时为NULL */
+    size_t size;        /* 映射长度 */
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+} input;
+
+/* 双缓冲读取：读线程填充一个缓冲区时，调用线程哈希另一个 */
+typedef struct {
+    int fd;
+    uint8_t *buf[2];
+    size_t len[2];
+    int full[2];
+    int err;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} reader;
+
+typedef void (*sink_fn)(void *arg, const uint8_t *data, size_t len);
+
+static void *aligned_buffer(size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, IO_BUFFER_ALIGN);
+#else
+    void *p;
+    return posix_memalign(&p, IO_BUFFER_ALIGN, size) == 0 ? p : NULL;
+#endif
+}
+
+static void aligned_free(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+static int input_open(input *in, const char *path) {
+    struct stat st;
+
+    in->map = NULL;
+    in->size = 0;
+#ifdef _WIN32
+    in->mapping = NULL;
+#endif
+
+    in->fd = strcmp(path, "-") == 0 ? 0 : open(path, O_RDONLY | O_BINARY);
+    if (in->fd < 0)
+        return -1;
+
+    /* 只映射非空的普通文件，管道与标准输入走读取路径 */
+    if (fstat(in->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+        return 0;
+
+#ifdef _WIN32
+    in->mapping = CreateFileMapping((HANDLE)_get_osfhandle(in->fd), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (in->mapping != NULL) {
+        in->map = MapViewOfFile(in->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (in->map == NULL) {
+            CloseHandle(in->mapping);
+            in->mapping = NULL;
+        }
+    }
+#else
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+    if (p != MAP_FAILED) {
+        /* 顺序访问：让内核加大预读并及时回收已读页 */
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        in->map = p;
+    }
+#endif
+    if (in->map != NULL)
+        in->size = (size_t)st.st_size;
+
+    return 0;
+}
+
+static void input_close(input *in) {
+    if (in->map != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(in->map);
+        CloseHandle(in->mapping);
+#else
+        munmap((void *)in->map, in->size);
+#endif
+    }
+    if (in->fd > 0)
+        close(in->fd);
+}
+
+static void *reader_thread(void *arg) {
+    reader *rd = arg;
+    size_t n;
+    ssize_t r;
+
+    for (int i = 0;; i ^= 1) {
+        pthread_mutex_lock(&rd->lock);
+        while (rd->full[i])
+            pthread_cond_wait(&rd->cond, &rd->lock);
+        pthread_mutex_unlock(&rd->lock);
+
+        /* 尽量填满缓冲区；长度为0表示结束 */
+        for (n = 0; n < IO_BUFFER_SIZE; n += (size_t)r) {
+            r = read(rd->fd, rd->buf[i] + n, IO_BUFFER_SIZE - n);
+            if (r < 0 && errno == EINTR) {
+                r = 0;
+                continue;
+            }
+            if (r <= 0)
+                break;
+        }
+
+        pthread_mutex_lock(&rd->lock);
+        if (r < 0)
+            rd->err = 1;
+        rd->len[i] = r < 0 ? 0 : n;
+        rd->full[i] = 1;
+        pthread_cond_broadcast(&rd->cond);
+        n = rd->len[i];
+        pthread_mutex_unlock(&rd->lock);
+
+        if (n == 0)
+            break;
+    }
+    return NULL;
+}
+
+/* 把输入按顺序交给sink：映射的文件一次交出，其余双缓冲读取 */
+static int input_stream(input *in, sink_fn sink, void *arg) {
+    reader rd;
+    pthread_t tid;
+    size_t n;
+    int ret = 0;
+
+    if (in->map != NULL) {
+        sink(arg, in->map, in->size);
+        return 0;
+    }
+
+    rd.fd = in->fd;
+    rd.buf[0] = aligned_buffer(IO_BUFFER_SIZE);
+    rd.buf[1] = aligned_buffer(IO_BUFFER_SIZE);
+    rd.full[0] = rd.full[1] = 0;
+    rd.err = 0;
+    if (rd.buf[0] == NULL || rd.buf[1] == NULL) {
+        aligned_free(rd.buf[0]);
+        aligned_free(rd.buf[1]);
+        return -1;
+    }
+    pthread_mutex_init(&rd.lock, NULL);
+    pthread_cond_init(&rd.cond, NULL);
+
+    if (pthread_create(&tid, NULL, reader_thread, &rd) != 0) {
+        ret = -1;
+    } else {
+        for (int i = 0;; i ^= 1) {
+            pthread_mutex_lock(&rd.lock);
+            while (!rd.full[i])
+                pthread_cond_wait(&rd.cond, &rd.lock);
+            n = rd.len[i];
+            pthread_mutex_unlock(&rd.lock);
+
+            if (n == 0)
+                break;
+            sink(arg, rd.buf[i], n);
+
+            pthread_mutex_lock(&rd.lock);
+            rd.full[i] = 0;
+            pthread_cond_broadcast(&rd.cond);
+            pthread_mutex_unlock(&rd.lock);
+        }
+        pthread_join(tid, NULL);
+        ret = rd.err ? -1 : 0;
+    }
+
+    pthread_cond_destroy(&rd.cond);
+    pthread_mutex_destroy(&rd.lock);
+    aligned_free(rd.buf[0]);
+    aligned_free(rd.buf[1]);
+    return ret;
+}
+
+static void sm3_sink(void *arg, const uint8_t *data, size_t len) {
+    SM3_Update(arg, data, len);
+}
+
+static void tree_sink(void *arg, const uint8_t *data, size_t len) {
+    SM3_Tree_Update(arg, data, len);
+}
+
+static void put_hex(FILE *fp, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        fprintf(fp, "%02x", data[i]);
+}
+
+/* 定长输出：256位大整数写成64个十六进制字符 */
+static void put_bn(FILE *fp, const bn_t a) {
+    for (int i = 3; i >= 0; i--)
+        fprintf(fp, "%016llX", (unsigned long long)(i < (int)a->used ? a->dp[i] : 0));
+}
+
+/* 读取文件中的一行十六进制串，拆成count个256位大整数 */
+static int read_bns(const char *path, bn_st *out[], int count) {
+    char line[4 * 64 + 2], part[65];
+    FILE *fp = fopen(path, "r");
+    size_t len;
+
+    if (fp == NULL)
+        return -1;
+    if (fgets(line, sizeof(line), fp) == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    len = strcspn(line, "\r\n");
+    if (len != (size_t)count * 64 || strspn(line, "0123456789abcdefABCDEF") < len)
+        return -1;
+
+    for (int i = 0; i < count; i++) {
+        memcpy(part, line + i * 64, 64);
+        part[64] = '\0';
+        bn_from_hex(out[i], part);
+    }
+    return 0;
+}
+
+/* 消息杂凑值e = H(Z || 文件内容) */
+static int digest_file(const char *path, group *g, const point *pub, const char *id, uint8_t e[SM3_DIGEST_SIZE]) {
+    uint8_t z[SM3_DIGEST_SIZE];
+    SM3_CTX ctx;
+    input in;
+    int ret;
+
+    if (SM2_ComputeZ(z, g, pub, (const uint8_t *)id, strlen(id)) != SM2_SUCCESS)
+        return -1;
+    if (input_open(&in, path) != 0)
+        return -1;
+
+    SM3_Init(&ctx);
+    SM3_Update(&ctx, z, SM3_DIGEST_SIZE);
+    ret = input_stream(&in, sm3_sink, &ctx);
+    SM3_Final(&ctx, e);
+
+    input_close(&in);
+    return ret;
+}
+
+static int cmd_keygen(int argc, char **argv) {
+    SM2_PRI_KEY pri_key;
+    SM2_PUB_KEY pub_key;
+    group g;
+    FILE *fp;
+    int fd;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: sm2tool keygen PRIKEY PUBKEY\n");
+        return 2;
+    }
+
+    if (SM2_GenerateKeyPair(&pri_key, &pub_key, &g) != SM2_SUCCESS)
+        return 1;
+
+    /* 私钥文件仅所有者可读写 */
+    fd = open(argv[0], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || (fp = fdopen(fd, "w")) == NULL) {
+        fprintf(stderr, "sm2tool: cannot write %s\n", argv[0]);
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    put_bn(fp, pri_key.d);
+    fprintf(fp, "\n");
+    fclose(fp);
+
+    fp = fopen(argv[1], "w");
+    if (fp == NULL) {
+        fprintf(stderr, "sm2tool: cannot write %s\n", argv[1]);
+        return 1;
+    }
+    put_bn(fp, pub_key.p.x);
+    put_bn(fp, pub_key.p.y);
+    fprintf(fp, "\n");
+    fclose(fp);
+
+    return 0;
+}
+
+static int cmd_hash(int argc, char **argv) {
+    uint8_t digest[SM3_DIGEST_SIZE];
+    int tree = 0, threads = 1, status = 0, i;
+
+    for (i = 0; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "-t") == 0) {
+            tree = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: sm2tool hash [-t] [-j THREADS] FILE...\n");
+            return 2;
+        }
+    }
+
+    for (; i < argc; i++) {
+        input in;
+        int ret;
+
+        if (input_open(&in, argv[i]) != 0) {
+            fprintf(stderr, "sm2tool: cannot open %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+
+        if (tree && in.map != NULL) {
+            /* 映射的文件直接多线程树哈希 */
+            ret = SM3_Tree(in.map, in.size, threads, digest) == SM3_SUCCESS ? 0 : -1;
+        } else if (tree) {
+            SM3_TREE_CTX ctx;
+            SM3_Tree_Init(&ctx);
+            ret = input_stream(&in, tree_sink, &ctx);
+            SM3_Tree_Final(&ctx, digest);
+        } else {
+            SM3_CTX ctx;
+            SM3_Init(&ctx);
+            ret = input_stream(&in, sm3_sink, &ctx);
+            SM3_Final(&ctx, digest);
+        }
+        input_close(&in);
+
+        if (ret != 0) {
+            fprintf(stderr, "sm2tool: read error on %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        put_hex(stdout, digest, SM3_DIGEST_SIZE);
+        printf("  %s\n", argv[i]);
+    }
+
+    return status;
+}
+
+static int cmd_sign(int argc, char **argv) {
+    const char *key_path = NULL, *id = DEFAULT_ID;
+    uint8_t e[SM3_DIGEST_SIZE], d[SM2_SCALAR_SIZE];
+    SM2_PRI_KEY pri_key;
+    SM2_SIG sig;
+    bn_t t;
+    group g;
+    int status = 0, i;
+
+    for (i = 0; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-k") == 0)
+            key_path = argv[i + 1];
+        else if (strcmp(argv[i], "-i") == 0)
+            id = argv[i + 1];
+        else
+            break;
+    }
+    if (key_path == NULL || i == argc) {
+        fprintf(stderr, "usage: sm2tool sign -k PRIKEY [-i ID] FILE...\n");
+        return 2;
+    }
+
+    create_group(&g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
+                 SM2_CURVE_PARAM_N);
+    /* 经SM2_DecodePriKey检查1 <= d <= n - 2，并计算Z需要的公钥（只计算一次） */
+    bn_new(t);
+    if (read_bns(key_path, (bn_st *[]){t}, 1) != 0) {
+        fprintf(stderr, "sm2tool: invalid private key %s\n", key_path);
+        return 1;
+    }
+    bn_to_bytes(d, sizeof(d), t);
+    if (SM2_DecodePriKey(&pri_key, &g, d) != SM2_SUCCESS) {
+        fprintf(stderr, "sm2tool: invalid private key %s\n", key_path);
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        char sig_path[4096];
+        FILE *fp;
+
+        /* 签名写入FILE.sig，标准输入没有对应的文件名 */
+        if (strcmp(argv[i], "-") == 0) {
+            fprintf(stderr, "sm2tool: cannot sign standard input, signature would be written to -.sig\n");
+            status = 1;
+            continue;
+        }
+        if (digest_file(argv[i], &g, &pri_key.p, id, e) != 0) {
+            fprintf(stderr, "sm2tool: cannot read %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        if (SM2_SignDigest(&pri_key, &g, e, &sig) != SM2_SUCCESS) {
+            fprintf(stderr, "sm2tool: signing %s failed\n", argv[i]);
+            status = 1;
+            continue;
+        }
+
+        snprintf(sig_path, sizeof(sig_path), "%s.sig", argv[i]);
+        fp = fopen(sig_path, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "sm2tool: cannot write %s\n", sig_path);
+            status = 1;
+            continue;
+        }
+        put_bn(fp, sig.r);
+        put_bn(fp, sig.s);
+        fprintf(fp, "\n");
+        fclose(fp);
+        printf("%s: signed\n", argv[i]);
+    }
+
+    return status;
+}
+
+static int cmd_verify(int argc, char **argv) {
+    const char *key_path = NULL, *id = DEFAULT_ID;
+    uint8_t e[SM3_DIGEST_SIZE], pub[SM2_PUB_SIZE];
+    SM2_PUB_KEY pub_key;
+    bn_t x, y;
+    SM2_SIG sig;
+    group g;
+    int status = 0, i;
+
+    for (i = 0; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-p") == 0)
+            key_path = argv[i + 1];
+        else if (strcmp(argv[i], "-i") == 0)
+            id = argv[i + 1];
+        else
+            break;
+    }
+    if (key_path == NULL || i == argc) {
+        fprintf(stderr, "usage: sm2tool verify -p PUBKEY [-i ID] FILE...\n");
+        return 2;
+    }
+
+    create_group(&g, SM2_CURVE_PARAM_P, SM2_CURVE_PARAM_A, SM2_CURVE_PARAM_B, SM2_CURVE_PARAM_GX, SM2_CURVE_PARAM_GY,
+                 SM2_CURVE_PARAM_N);
+    /* 按04 || x || y经SM2_DecodePubKey载入，拒绝不在曲线上的公钥 */
+    bn_new(x);
+    bn_new(y);
+    if (read_bns(key_path, (bn_st *[]){x, y}, 2) != 0) {
+        fprintf(stderr, "sm2tool: invalid public key %s\n", key_path);
+        return 1;
+    }
+    pub[0] = 0x04;
+    bn_to_bytes(pub + 1, SM2_SCALAR_SIZE, x);
+    bn_to_bytes(pub + 1 + SM2_SCALAR_SIZE, SM2_SCALAR_SIZE, y);
+    point_new(&pub_key.p);
+    if (SM2_DecodePubKey(&pub_key, &g, pub, sizeof(pub)) != SM2_SUCCESS) {
+        fprintf(stderr, "sm2tool: invalid public key %s\n", key_path);
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        char sig_path[4096];
+
+        snprintf(sig_path, sizeof(sig_path), "%s.sig", argv[i]);
+        bn_new(sig.r);
+        bn_new(sig.s);
+        if (read_bns(sig_path, (bn_st *[]){sig.r, sig.s}, 2) != 0) {
+            printf("%s: FAILED (missing or malformed %s)\n", argv[i], sig_path);
+            status = 1;
+            continue;
+        }
+        if (digest_file(argv[i], &g, &pub_key.p, id, e) != 0) {
+            fprintf(stderr, "sm2tool: cannot read %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+
+        if (SM2_VerifyDigest(&pub_key, &g, e, &sig) == SM2_SUCCESS) {
+            printf("%s: OK\n", argv[i]);
+        } else {
+            printf("%s: FAILED\n", argv[i]);
+            status = 1;
+        }
+    }
+
+    return status;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "keygen") == 0)
+        return cmd_keygen(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "hash") == 0)
+        return cmd_hash(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "sign") == 0)
+        return cmd_sign(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "verify") == 0)
+        return cmd_verify(argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: sm2tool keygen PRIKEY PUBKEY\n"
+                    "       sm2tool hash [-t] [-j THREADS] FILE...\n"
+                    "       sm2tool sign -k PRIKEY [-i ID] FILE...\n"
+                    "       sm2tool verify -p PUBKEY [-i ID] FILE...\n");
+    return 2;
+}